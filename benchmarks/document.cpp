@@ -0,0 +1,68 @@
+#include <son.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <sys/resource.h>
+
+using namespace jslavic;
+
+// Parses a file several times, once per process for each mode, so that peak RSS is of that mode only:
+//     document heap config.son
+//     document arena config.son
+// Time is of the best run, and covers both parsing and destroying the tree.
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3 or (strcmp(argv[1], "heap") != 0 and strcmp(argv[1], "arena") != 0)) {
+		printf("usage: %s heap|arena <file> [runs]\n", argv[0]);
+		return 1;
+	}
+
+	bool use_arena = strcmp(argv[1], "arena") == 0;
+	int runs = argc > 3 ? atoi(argv[3]) : 5;
+
+	double best_parse = 1e9;
+	double best_destroy = 1e9;
+
+	for (int i = 0; i < runs; i++) {
+		parser p(argv[2]);
+		bool successful = false;
+
+		if (use_arena) {
+			document* doc = new document();
+
+			auto start = std::chrono::steady_clock::now();
+			successful = p.parse_into(*doc);
+			best_parse = std::min(best_parse, seconds_since(start));
+
+			start = std::chrono::steady_clock::now();
+			delete doc;
+			best_destroy = std::min(best_destroy, seconds_since(start));
+		} else {
+			son* value = new son();
+
+			auto start = std::chrono::steady_clock::now();
+			successful = p.parse_into(*value);
+			best_parse = std::min(best_parse, seconds_since(start));
+
+			start = std::chrono::steady_clock::now();
+			delete value;
+			best_destroy = std::min(best_destroy, seconds_since(start));
+		}
+
+		if (not successful) {
+			printf("%s: could not parse\n", argv[2]);
+			return 1;
+		}
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("%-5s parse %8.1f ms, destroy %7.1f ms, total %8.1f ms, peak RSS %7.1f MiB\n", argv[1],
+		best_parse * 1000, best_destroy * 1000, (best_parse + best_destroy) * 1000, usage.ru_maxrss / 1024.0);
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <son.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+using namespace jslavic;
+
+// Builds a deeply indented, commented config in memory, like generated ones, and prints the best
+// throughput of parsing it. The tree is parsed into again each time, so its memory is reused and
+// most of the time goes to skipping spaces and comments:
+//     indented
+//     indented 200000 8
+//     indented 200000 8 10
+// Arguments are the number of entries, the indentation step in spaces and the number of runs.
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string make_text(size_t entries, size_t step) {
+	std::string text;
+	size_t depth = 0;
+
+	for (size_t i = 0; i < entries; i++) {
+		std::string indent(depth * step, ' ');
+
+		if (i % 8 == 0) {
+			text += indent + "// Entry " + std::to_string(i) + ", generated; comments are skipped in blocks too.\n";
+		}
+
+		// Nesting goes down to 9 levels and back up, a level every 32 entries.
+		size_t target = (i / 32) % 18 < 9 ? (i / 32) % 18 : 18 - (i / 32) % 18;
+
+		if (depth < target) {
+			text += indent + "group_" + std::to_string(i) + " = {\n";
+			depth += 1;
+			continue;
+		}
+
+		if (depth > target) {
+			depth -= 1;
+			text += std::string(depth * step, ' ') + "}\n";
+			continue;
+		}
+
+		text += indent + "entry_" + std::to_string(i) + " = " + std::to_string(i) + ";\n\n";
+	}
+
+	while (depth > 0) {
+		depth -= 1;
+		text += std::string(depth * step, ' ') + "}\n";
+	}
+
+	return text;
+}
+
+int main(int argc, char** argv) {
+	size_t entries = argc > 1 ? atol(argv[1]) : 200000;
+	size_t step = argc > 2 ? atol(argv[2]) : 8;
+	int runs = argc > 3 ? atoi(argv[3]) : 10;
+
+	if (entries == 0) {
+		printf("usage: %s [entries] [indentation] [runs]\n", argv[0]);
+		return 1;
+	}
+
+	std::string text = make_text(entries, step);
+
+	size_t spaces = 0;
+	for (char c : text) {
+		spaces += (c == ' ' or c == '\n');
+	}
+
+	double best = 1e9;
+	parser p{std::string()};
+	son value;
+
+	for (int i = 0; i < runs; i++) {
+		auto start = std::chrono::steady_clock::now();
+		bool successful = p.parse_into(text, value);
+		best = std::min(best, seconds_since(start));
+
+		if (not successful) {
+			printf("could not parse\n");
+			return 1;
+		}
+	}
+
+	printf("%zu bytes, %.0f%% spaces\n", text.size(), 100.0 * spaces / text.size());
+	printf("parse %8.1f ms, %7.1f MB/s\n", best * 1000, text.size() / best / 1e6);
+	return 0;
+}
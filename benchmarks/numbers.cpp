@@ -0,0 +1,101 @@
+#include <son.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace jslavic;
+
+// Builds a number-dense document in memory, like telemetry, and prints the best time of parsing it:
+//     numbers
+//     numbers 200000
+//     numbers 200000 10
+// Every sample has timestamps and counters, which are integers, and readings with up to 15 decimals,
+// which are floating, without exponents so that older versions parse them too. The tree is parsed
+// into again each time, so its memory is reused. Readings are also compared with strtod, and those
+// that are not correctly rounded are counted.
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string make_text(size_t samples, std::vector<double>& readings) {
+	static const char* names[] = { "time", "count", "cpu", "temperature", "ratio", "offset" };
+	std::string text = "samples = [\n";
+	uint64_t seed = 1;
+	char number[64];
+
+	for (size_t i = 0; i < samples; i++) {
+		text += "{ ";
+		for (size_t j = 0; j < 6; j++) {
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			uint64_t bits = seed >> 16;
+
+			switch (j) {
+			case 0: snprintf(number, sizeof(number), "%llu", 1700000000000ull + i * 1000 + bits % 1000); break;
+			case 1: snprintf(number, sizeof(number), "%llu", (unsigned long long)(bits % 100000000)); break;
+			case 2: snprintf(number, sizeof(number), "%.5f", (bits % 100000) / 100000.0); break;
+			case 3: snprintf(number, sizeof(number), "%.2f", (int64_t(bits % 20000) - 10000) / 100.0); break;
+			case 4: snprintf(number, sizeof(number), "%.15f", (bits % 1000000007) / 1000000007.0 / 1000.0); break;
+			case 5: snprintf(number, sizeof(number), "%lld", (long long)(int64_t(bits % 2000001) - 1000000)); break;
+			}
+
+			if (strchr(number, '.')) {
+				readings.push_back(strtod(number, nullptr));
+			}
+
+			text += names[j];
+			text += " = ";
+			text += number;
+			text += "; ";
+		}
+		text += "}\n";
+	}
+
+	text += "]\n";
+	return text;
+}
+
+int main(int argc, char** argv) {
+	size_t samples = argc > 1 ? atol(argv[1]) : 200000;
+	int runs = argc > 2 ? atoi(argv[2]) : 10;
+
+	if (samples == 0) {
+		printf("usage: %s [samples] [runs]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<double> readings;
+	std::string text = make_text(samples, readings);
+
+	double best = 1e9;
+	parser p{std::string()};
+	son value;
+
+	for (int i = 0; i < runs; i++) {
+		auto start = std::chrono::steady_clock::now();
+		bool successful = p.parse_into(text, value);
+		best = std::min(best, seconds_since(start));
+
+		if (not successful) {
+			printf("could not parse\n");
+			return 1;
+		}
+	}
+
+	size_t wrong = 0;
+	size_t next = 0;
+	for (const son& sample : value["samples"]) {
+		for (const son& field : sample) {
+			if (field.is_floating()) {
+				double parsed = field.get_floating();
+				wrong += memcmp(&readings[next++], &parsed, sizeof(double)) != 0;
+			}
+		}
+	}
+
+	printf("%zu numbers, %zu bytes, %zu of %zu readings are not correctly rounded\n", samples * 6, text.size(), wrong, readings.size());
+	printf("parse %8.1f ms, %7.1f MB/s, %6.1f M numbers/s\n", best * 1000, text.size() / best / 1e6, samples * 6 / best / 1e6);
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include <son.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <sys/resource.h>
+
+using namespace jslavic;
+
+// Builds a string-heavy document in memory, parses it several times and prints the best times:
+//     strings
+//     strings 1000000 8
+//     strings 1000000 40 3
+// Every record has a few string values, each of up to the given length. Times are of parsing,
+// reading all strings through views, copying the tree and destroying both trees.
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string make_text(size_t records, size_t length) {
+	static const char* names[] = { "name", "kind", "state", "owner" };
+	std::string text = "records = [\n";
+	uint32_t seed = 1;
+
+	for (size_t i = 0; i < records; i++) {
+		text += "{ ";
+		for (const char* name : names) {
+			seed = seed * 1664525 + 1013904223;
+			size_t size = 1 + (seed >> 8) % length;
+
+			text += name;
+			text += " = \"";
+			for (size_t j = 0; j < size; j++) {
+				text += char('a' + (seed >> (j % 24)) % 26);
+			}
+			text += "\"; ";
+		}
+		text += "}\n";
+	}
+
+	text += "]\n";
+	return text;
+}
+
+static size_t read_strings(const son& value) {
+	if (value.is_string()) {
+		return value.get_string_view().size();
+	}
+
+	size_t total = 0;
+	for (const son& child : value) {
+		if (child.is_object() or child.is_array() or child.is_string()) {
+			total += read_strings(child);
+		}
+	}
+	return total;
+}
+
+int main(int argc, char** argv) {
+	size_t records = argc > 1 ? atol(argv[1]) : 500000;
+	size_t length = argc > 2 ? atol(argv[2]) : 12;
+	int runs = argc > 3 ? atoi(argv[3]) : 5;
+
+	if (records == 0 or length == 0) {
+		printf("usage: %s [records] [length] [runs]\n", argv[0]);
+		return 1;
+	}
+
+	std::string text = make_text(records, length);
+
+	double best_parse = 1e9;
+	double best_read = 1e9;
+	double best_copy = 1e9;
+	double best_destroy = 1e9;
+	size_t characters = 0;
+
+	for (int i = 0; i < runs; i++) {
+		parser p{std::string()};
+		son* value = new son();
+
+		auto start = std::chrono::steady_clock::now();
+		if (not p.parse_into(text, *value)) {
+			printf("could not parse\n");
+			return 1;
+		}
+		best_parse = std::min(best_parse, seconds_since(start));
+
+		start = std::chrono::steady_clock::now();
+		characters = read_strings(*value);
+		best_read = std::min(best_read, seconds_since(start));
+
+		start = std::chrono::steady_clock::now();
+		son* copy = new son(*value);
+		best_copy = std::min(best_copy, seconds_since(start));
+
+		start = std::chrono::steady_clock::now();
+		delete copy;
+		delete value;
+		best_destroy = std::min(best_destroy, seconds_since(start));
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("%zu strings of up to %zu bytes, %zu bytes in all\n", records * 4, length, characters);
+	printf("parse %8.1f ms, read %6.1f ms, copy %7.1f ms, destroy %7.1f ms, peak RSS %7.1f MiB\n",
+		best_parse * 1000, best_read * 1000, best_copy * 1000, best_destroy * 1000, usage.ru_maxrss / 1024.0);
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include <son.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+using namespace jslavic;
+
+// Parses a file that is already in memory several times and prints the best throughput:
+//     throughput sax big.son
+//     throughput dom big.son
+//     throughput sax big.son 5 utf8
+// Events only measure the lexer and the parser, dom also builds the tree. With utf8 strings are validated.
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3 or (strcmp(argv[1], "sax") != 0 and strcmp(argv[1], "dom") != 0)) {
+		printf("usage: %s sax|dom <file> [runs] [utf8]\n", argv[0]);
+		return 1;
+	}
+
+	bool use_sax = strcmp(argv[1], "sax") == 0;
+	int runs = argc > 3 ? atoi(argv[3]) : 5;
+
+	parser::settings_t settings;
+	settings.validate_utf8 = argc > 4 and strcmp(argv[4], "utf8") == 0;
+
+	std::ifstream file(argv[2], std::ios::binary);
+	if (not file) {
+		printf("%s: could not read the file\n", argv[2]);
+		return 1;
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	std::string text = stream.str();
+
+	double best = 1e9;
+
+	for (int i = 0; i < runs; i++) {
+		parser p(std::string(), settings);
+		son value; // Destroyed after the time is taken.
+		bool successful = false;
+
+		auto start = std::chrono::steady_clock::now();
+		if (use_sax) {
+			sax_handler handler;
+			successful = p.parse(text, handler);
+		} else {
+			successful = p.parse_into(text, value);
+		}
+		best = std::min(best, seconds_since(start));
+
+		if (not successful) {
+			printf("%s: could not parse\n", argv[2]);
+			return 1;
+		}
+	}
+
+	printf("%-3s %8.1f ms, %7.1f MB/s\n", argv[1], best * 1000, text.size() / best / 1e6);
+	return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef SON_CURSOR_HPP
+#define SON_CURSOR_HPP
+
+
+#include <stdint.h>
+#include <string_view>
+#include <memory>
+
+
+namespace jslavic {
+
+
+// Reads a document one event at a time, without building son values.
+// Text is not copied, so it has to outlive the cursor.
+//
+//     cursor c(text);
+//     while (c.next()) {
+//         if (c.key() == "id") id = c.get_integer();
+//         else c.skip_value();
+//     }
+//
+// Keys and strings are views into the text. String with escape sequences is decoded into
+// a buffer of the cursor instead, which is valid until the next call of next() or skip_value().
+// Top level is reported the same way as to sax_handler: object without braces as an object,
+// other values one by one.
+class cursor {
+public:
+    enum class kind_t {
+        none, // Before the first next().
+        null,
+        boolean,
+        integer,
+        floating,
+        string,
+        object_begin,
+        object_end,
+        array_begin,
+        array_end,
+    };
+
+    struct impl_t;
+
+private:
+    std::unique_ptr<impl_t> impl;
+
+public:
+    cursor(std::string_view text);
+    ~cursor();
+
+    cursor(cursor&&);
+    cursor& operator=(cursor&&);
+
+    // Moves to the next event. Returns false at the end of the document or on error.
+    bool next();
+
+    // Skips children of the current object or array, the cursor stops at its end event.
+    // Skipped part is only lexed, it is not checked against the grammar. Does nothing for other values.
+    bool skip_value();
+
+    kind_t kind() const;
+    std::string_view key() const; // Key of the current value inside of an object, empty otherwise.
+    size_t depth() const;         // How many objects and arrays are open.
+    bool failed() const;
+
+    bool get_boolean() const;
+    int64_t get_integer() const;
+    double get_floating() const; // Integers are converted.
+    std::string_view get_string() const;
+};
+
+
+} // jslavic
+
+
+#endif // SON_CURSOR_HPP
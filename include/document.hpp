@@ -0,0 +1,44 @@
+#ifndef SON_DOCUMENT_HPP
+#define SON_DOCUMENT_HPP
+
+
+#include <memory>
+#include <memory_resource>
+#include "value.hpp"
+
+
+namespace jslavic {
+
+
+// Parsed tree whose strings, objects and arrays are allocated from an arena that belongs to the document.
+// Every object and array is allocated once with its final size, nothing is freed one by one,
+// and the whole arena is released at once when the document is cleared, parsed into again or destroyed.
+//
+// Values of the tree point into the arena even when they are moved out of it, so only copies
+// may outlive the document. Values moved into the tree from outside keep their own memory.
+class document {
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+    son root; // Destroyed before the arena. Its destructors only walk the tree, the arena ignores deallocations.
+
+public:
+    document();
+    ~document();
+
+    document(document&& other) noexcept;
+    document& operator=(document&& other) noexcept;
+
+    son& value() { return root; }
+    const son& value() const { return root; }
+
+    // Memory for values that are added to the tree and should live as long as the document.
+    std::pmr::memory_resource* resource();
+
+    // Destroys the tree and releases the arena.
+    void clear();
+};
+
+
+} // jslavic
+
+
+#endif // SON_DOCUMENT_HPP
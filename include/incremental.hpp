@@ -0,0 +1,56 @@
+#ifndef SON_INCREMENTAL_HPP
+#define SON_INCREMENTAL_HPP
+
+
+#include <string_view>
+#include <memory>
+#include "value.hpp"
+#include "parser.hpp"
+
+
+namespace jslavic {
+
+
+// Parses text that arrives in pieces, e.g. from a pipe or a socket. A piece may end anywhere,
+// even in the middle of a token: the unfinished part is kept until the next feed().
+//
+// With a handler, events are reported as soon as their tokens are complete. Keys are reported
+// when they are read, before '='. Strings and keys are valid only during the call.
+// Without a handler, every top level value is collected when it closes and is taken with next_value().
+// Object without braces at the top level is one value that closes at finish().
+class incremental_parser {
+public:
+    struct impl_t;
+
+private:
+    std::unique_ptr<impl_t> impl;
+
+public:
+    incremental_parser();
+    incremental_parser(sax_handler& handler);
+    ~incremental_parser();
+
+    incremental_parser(incremental_parser&&);
+    incremental_parser& operator=(incremental_parser&&);
+
+    // Returns false on error, or if the handler stopped parsing.
+    bool feed(const char* data, size_t size);
+    bool feed(std::string_view text) { return feed(text.data(), text.size()); }
+    // Same, but the text is lexed where it is, without a copy: it has to follow the text of the previous
+    // feed_in_place() right after it in memory, like slices of a memory-mapped file, and stay valid until finish().
+    bool feed_in_place(const char* data, size_t size);
+
+    // There will be no more input: the last token and the top level are closed.
+    bool finish();
+
+    // Takes the oldest collected value, returns false if there is none yet.
+    bool next_value(son& value);
+
+    bool failed() const;
+};
+
+
+} // jslavic
+
+
+#endif // SON_INCREMENTAL_HPP
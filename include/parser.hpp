@@ -3,36 +3,137 @@
 
 
 #include <string>
+#include <string_view>
+#include <memory>
+#include <vector>
 #include "value.hpp"
 
 
 namespace jslavic {
 
 
+class document;
+
+
+// Receives what the parser finds, in document order, without building son values.
+// Keys and strings without escape sequences point into the parsed text, and are valid only as long as
+// the text is. Strings with escapes are decoded into a buffer that is valid only during the event.
+// Returning false from an event stops parsing.
+//
+// Object without braces at the top level is reported as an object. Values at the top level
+// that are not in brackets are reported one by one, parse() puts them into a list.
+struct sax_handler {
+    virtual ~sax_handler() = default;
+
+    virtual bool on_null() { return true; }
+    virtual bool on_boolean(bool) { return true; }
+    virtual bool on_integer(int64_t) { return true; }
+    virtual bool on_floating(double) { return true; }
+    virtual bool on_string(std::string_view) { return true; }
+
+    virtual bool on_key(std::string_view) { return true; }
+
+    virtual bool on_object_begin() { return true; }
+    virtual bool on_object_end() { return true; }
+    virtual bool on_array_begin() { return true; }
+    virtual bool on_array_end() { return true; }
+};
+
+
+// Appends raw string, as son_view gives it, to out with escape sequences decoded.
+// Returns false if it has a sequence that is not valid, out has what was before it.
+bool unescape(std::string_view raw, std::string& out);
+
+
 class parser {
 public:
     struct settings_t {
         bool require_semicolons = false;
         bool require_commas = false;
+        bool use_mmap = true; // Map regular files into memory instead of reading them.
+        size_t max_spare_containers = 4096; // How many cleared objects and arrays are kept for the next parse.
+        size_t threads = 1; // Parts of a large top level object or array are parsed on this many threads, 0 is one per core.
+        size_t parallel_threshold = 16 * 1024 * 1024; // Texts smaller than this are always parsed on one thread.
+        bool intern_keys = false; // Keys of objects are interned, see intern().
+        bool validate_utf8 = false; // Strings that are not valid UTF-8 are errors, with the byte offset of the first bad sequence.
+
+        // Limits for untrusted input, 0 is no limit. Parsing stops with an error that names the limit.
+        size_t max_depth = 1024; // Objects and arrays nested in each other.
+        size_t max_bytes = 0; // Size of the text.
+        size_t max_nodes = 0; // Values in the document, objects and arrays included.
+        size_t max_string_length = 0; // Bytes in a string or a key, escapes are not decoded.
     };
 
+    struct scratch_t; // Buffers reused between parse calls.
+
 private:
     std::string filename;
+    std::unique_ptr<scratch_t> scratch;
+
+public:
+    settings_t settings;
 
 public:
-    parser(const char* filename) : filename(filename) {}
-    parser(std::string filename) : filename(std::move(filename)) {}
+    parser();
+    parser(const char* filename);
+    parser(std::string filename);
+    parser(std::string filename, settings_t settings);
+    ~parser();
 
+    parser(parser&&) noexcept;
+    parser& operator=(parser&&) noexcept;
+
+    // Parse the file given to the constructor.
     son parse();
+    // Parse text in memory. Input does not have to be null-terminated.
+    son parse(std::string_view text);
+
+    // Same as parse(), but the result goes into target, and its objects and arrays are reused.
+    // On failure target becomes null and false is returned.
+    bool parse_into(son& target);
+    bool parse_into(std::string_view text, son& target);
+
+    // Same, but the tree is allocated in the arena of the document, see document.
+    bool parse_into(document& target);
+    bool parse_into(std::string_view text, document& target);
+
+    // Report events to the handler instead of building son.
+    bool parse(sax_handler& handler);
+    bool parse(std::string_view text, sax_handler& handler);
+
+    // Parse only values at the paths, like "server.port" or "db.replicas[3].host", and skip the rest.
+    // Result is an object from paths to values; paths that are not in the document are not in it.
+    son parse_paths(const std::vector<std::string>& paths);
+    son parse_paths(std::string_view text, const std::vector<std::string>& paths);
+};
+
+
+// Result of one input of parse_many().
+struct parse_result {
+    son value;
+    bool successful = false;
+    std::string errors; // Messages that parse() would print, one per line.
 };
 
 
+// Parse many files, or texts in memory, on `threads` threads (0 is one per core). Every thread reuses
+// its parser buffers for the files it takes. Results are in the same order as the inputs.
+std::vector<parse_result> parse_many(const std::vector<std::string>& filenames, size_t threads = 0, parser::settings_t settings = parser::settings_t());
+std::vector<parse_result> parse_many_texts(const std::vector<std::string_view>& texts, size_t threads = 0, parser::settings_t settings = parser::settings_t());
+
+
 inline son parse(std::string filename) {
     parser parser(std::move(filename));
     return parser.parse();
 }
 
 
+inline son parse_paths(std::string filename, const std::vector<std::string>& paths) {
+    parser parser(std::move(filename));
+    return parser.parse_paths(paths);
+}
+
+
 } // jslavic
 
 
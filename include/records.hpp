@@ -0,0 +1,63 @@
+#ifndef SON_RECORDS_HPP
+#define SON_RECORDS_HPP
+
+
+#include <stdio.h>
+#include <string>
+#include <memory>
+#include "value.hpp"
+
+
+namespace jslavic {
+
+
+// Reads a file of consecutive top level values one record at a time. Only a window of text
+// and the records that closed in it are kept in memory, so files of any size are read in constant memory.
+// Regular files are memory-mapped and parsed in place, pages that were read are given back as the reader moves on.
+class record_reader {
+public:
+    struct impl_t;
+
+private:
+    std::unique_ptr<impl_t> impl;
+
+public:
+    record_reader(std::string filename, bool use_mmap = true);
+    ~record_reader();
+
+    record_reader(record_reader&&);
+    record_reader& operator=(record_reader&&);
+
+    // Returns false at the end of the file or on error.
+    bool next(son& record);
+
+    bool failed() const;
+};
+
+
+// Writes records one per line, the way record_reader reads them. A record that could not be read back,
+// with an infinite or NaN number or a key that is not an identifier, is not written and the writer fails.
+class record_writer {
+    FILE* output = nullptr;
+    bool owns_output = false;
+    bool failed = false;
+
+public:
+    record_writer(FILE* output);
+    record_writer(std::string filename);
+    ~record_writer();
+
+    record_writer(const record_writer&) = delete;
+    record_writer& operator=(const record_writer&) = delete;
+
+    bool write(const son& record);
+    bool flush();
+
+    bool good() const { return output and not failed; }
+};
+
+
+} // jslavic
+
+
+#endif // SON_RECORDS_HPP
@@ -3,5 +3,10 @@
 
 #include "value.hpp"
 #include "parser.hpp"
+#include "cursor.hpp"
+#include "incremental.hpp"
+#include "records.hpp"
+#include "view.hpp"
+#include "document.hpp"
 
 #endif // SON_LIB_HPP
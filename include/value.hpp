@@ -4,8 +4,12 @@
 #include <stdint.h>
 #include <assert.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <tuple>
+#include <atomic>
+#include <utility>
+#include <memory_resource>
 
 
 namespace jslavic {
@@ -26,9 +30,65 @@ public:
     using boolean_t = bool;
     using integer_t = int64_t;
     using floating_t = double;
-    using string_t = std::string;
-    using object_t = std::vector<std::pair<std::string, son>>;
-    using array_t = std::vector<son>;
+
+    // Key of a pair in an object. Keys up to 16 bytes are kept inside, longer ones take memory
+    // from the resource of their object. Interned keys (see intern) point to characters of the
+    // symbol table instead, and are compared by their ids when both sides are interned.
+    class key_t {
+    public:
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+        static constexpr size_t inline_capacity = 16;
+
+    private:
+        union {
+            char m_inline[inline_capacity];
+            struct {
+                const char* data;
+                std::pmr::memory_resource* resource; // nullptr if the characters belong to the symbol table.
+            } m_outside;
+        };
+        uint32_t m_size = 0;
+        uint32_t m_id = 0; // 0 if the key is not interned.
+
+        key_t(std::string_view stored, uint32_t id) noexcept;
+        friend key_t intern(std::string_view key);
+
+        bool is_inline() const noexcept { return m_id == 0 and m_size <= inline_capacity; }
+
+    public:
+        key_t() noexcept;
+        explicit key_t(std::string_view s, const allocator_type& allocator = allocator_type());
+        key_t(const key_t& other, const allocator_type& allocator = allocator_type());
+        key_t(key_t&& other) noexcept;
+        key_t(key_t&& other, const allocator_type& allocator) noexcept; // Keeps the memory of other.
+        ~key_t();
+
+        key_t& operator=(const key_t& other);
+        key_t& operator=(key_t&& other) noexcept;
+
+        void swap(key_t& other) noexcept;
+
+        std::string_view view() const noexcept { return std::string_view(is_inline() ? m_inline : m_outside.data, m_size); }
+        operator std::string_view() const noexcept { return view(); }
+        uint32_t id() const noexcept { return m_id; }
+
+        bool operator==(const key_t& other) const noexcept {
+            if (m_id != 0 and other.m_id != 0) return m_id == other.m_id;
+            return view() == other.view();
+        }
+        bool operator==(std::string_view other) const noexcept { return view() == other; }
+        bool operator!=(const key_t& other) const noexcept { return !(*this == other); }
+        bool operator!=(std::string_view other) const noexcept { return !(*this == other); }
+    };
+
+    // Strings, objects and arrays take memory from a memory_resource: the default one (heap),
+    // or an arena of a document. Copies always use the default one.
+    using string_t = std::pmr::string;
+    struct object_t; // Vector of pairs, see below.
+    using array_t = std::pmr::vector<son>;
+
+    // Strings up to this many bytes are kept in the value itself, without string_t.
+    static constexpr size_t short_string_capacity = 14;
 
 private:
     union value_t {
@@ -38,20 +98,31 @@ private:
         void* storage;
     } m_value;
 
+    // Characters of a short string start at m_value and go on in m_short_tail, right after it.
+    // m_short_size is their count, or long_string if the string is in storage.
+    static constexpr uint8_t long_string = 0xFF;
+
+    char m_short_tail[short_string_capacity - sizeof(value_t)];
+    uint8_t m_short_size = long_string;
     type_t m_type = type_t::null;
 
+    const char* short_chars() const noexcept { return reinterpret_cast<const char*>(this); }
+    char* short_chars() noexcept { return reinterpret_cast<char*>(this); }
+
 public:
     ~son();
 
     son(); // null.
     son(std::nullptr_t) noexcept; // Also null.
     son(type_t t) noexcept; // Default value of that type.
+    son(type_t t, std::pmr::memory_resource* resource) noexcept; // Same, string, object or array takes memory from the resource.
     son(boolean_t v) noexcept;
     son(integer_t v) noexcept;
     son(int32_t v) noexcept : son(static_cast<integer_t>(v)) {}
     son(floating_t v) noexcept;
     son(const char* s) noexcept;
     son(std::string s) noexcept;
+    son(std::string_view s, std::pmr::memory_resource* resource) noexcept;
     son(std::initializer_list<son>) noexcept;
 
     son(const son& other) noexcept;
@@ -76,22 +147,45 @@ public:
     bool get_boolean() const { assert(is_boolean()); return m_value.boolean; }
     integer_t get_integer() const { assert(is_integer()); return m_value.integer; }
     floating_t get_floating() const { assert(is_floating()); return m_value.floating; }
-    string_t get_string() const { assert(is_string()); return *(string_t*)m_value.storage; }
+    std::string get_string() const { return std::string(get_string_view()); }
+    std::string_view get_string_view() const { // Valid until the string is changed or destroyed.
+        assert(is_string());
+        if (m_short_size != long_string) return std::string_view(short_chars(), m_short_size);
+        return *(string_t*)m_value.storage;
+    }
 
     bool operator==(const son& other) const;
     bool operator!=(const son& other) const { return !(*this == other); }
 
     son& operator[](const char* key);
+    son& operator[](std::string_view key);
+    son& operator[](const key_t& key); // Compares ids if the key and the pairs are interned.
     son& operator[](int32_t idx);
 
+    // Const lookups never change the value: a missing key gives a null that is shared by all
+    // of them. Any number of threads may read one value at once, as long as none changes it.
     const son& operator[](const char* key) const;
+    const son& operator[](std::string_view key) const;
+    const son& operator[](const key_t& key) const;
     const son& operator[](int32_t idx) const;
 
-    son get(const char* key, const son& default_value);
-    son get(int32_t idx, const son& default_value);
+    // Value of the key, or nullptr if the value is not an object or has no such key.
+    son* find(std::string_view key);
+    son* find(const key_t& key);
+    const son* find(std::string_view key) const;
+    const son* find(const key_t& key) const;
+
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+    bool contains(const key_t& key) const { return find(key) != nullptr; }
+
+    son get(const char* key, const son& default_value) const;
+    son get(std::string_view key, const son& default_value) const;
+    son get(int32_t idx, const son& default_value) const;
 
-    void push(const std::string& key, const son& value);
-    void push(const son& value);
+    void push(std::string_view key, son value);
+    void push(key_t key, son value);
+    void push(son value);
+    void reserve(size_t capacity); // Room for that many pairs or elements.
 
     bool empty() const;
     size_t size() const;
@@ -168,7 +262,8 @@ public:
     struct object_iterator {
         Iterator it;
 
-        object_iterator(son* p) : it(p) {}
+        template <typename Son>
+        object_iterator(Son* p) : it(p) {} // son* or const son*, as the iterator has.
         void set_to_end() { it.set_to_end(); }
 
     public:
@@ -181,21 +276,18 @@ public:
         bool operator == (const object_iterator& other) const { return it == other.it; }
         bool operator != (const object_iterator& other) const { return !(*this == other); }
 
-        std::pair<std::string, son&> operator * () {
-            assert(it.p->is_object());
-
-            object_t* storage = (object_t*)it.p->m_value.storage;
-            return { (*storage)[it.idx].first, (*storage)[it.idx].second };
+        std::pair<std::string, decltype(*it)> operator * () { // son& or const son&.
+            return { std::string(key()), *it };
         }
 
-        std::string& key() const {
+        const key_t& key() const { // Keys are not changed in place, objects may have an index of them.
             assert(it.p->is_object());
 
             object_t* storage = (object_t*)it.p->m_value.storage;
-            return storage[it.idx].first;
+            return (*storage)[it.idx].first;
         }
 
-        son& value() const { return *it; }
+        decltype(auto) value() const { Iterator copy = it; return *copy; } // son& or const son&.
     };
 
     iterator begin() { return iterator(this); }
@@ -227,6 +319,37 @@ public:
 };
 
 
+// Pairs in the order they were pushed. Objects with many pairs also have an index of their keys:
+// the first lookup makes it and push keeps it up to date, so lookups do not go through every pair.
+struct son::object_t : std::pmr::vector<std::pair<son::key_t, son>> {
+    static constexpr size_t index_threshold = 16; // Smaller objects are searched pair by pair.
+
+    using vector::vector;
+    object_t(const object_t&) = delete; // Copies go through vector(const vector&, allocator), without the index.
+    object_t& operator=(const object_t&) = delete;
+    ~object_t();
+
+    // First pair with that key, or nullptr. Threads may look up the same object at once,
+    // as long as none of them changes it.
+    const value_type* find(std::string_view key) const;
+    const value_type* find(const key_t& key) const;
+    value_type* find(std::string_view key) { return const_cast<value_type*>(std::as_const(*this).find(key)); }
+    value_type* find(const key_t& key) { return const_cast<value_type*>(std::as_const(*this).find(key)); }
+
+    void index_last(); // After a pair was pushed.
+    void drop_index(); // After pairs were removed.
+
+private:
+    struct index_t;
+    mutable std::atomic<index_t*> m_index { nullptr }; // Made by a lookup, which may be on any thread.
+
+    template <typename Key>
+    const value_type* find_indexed(const Key& key, std::string_view characters) const;
+    index_t* make_index(size_t slot_count) const;
+    void insert_position(index_t* index, size_t position) const;
+};
+
+
 struct print_options {
     enum class multiline_t {
         disabled,
@@ -239,9 +362,16 @@ struct print_options {
     bool print_commas = true;
     int32_t indent = 2;
     multiline_t multiline = multiline_t::smart;
+    bool exact_floats = false; // Shortest form that is parsed back to the same float, instead of "%lf".
 };
 
 
+// Interns the key into the symbol table of the process, which is thread-safe. Characters of
+// interned keys are stored once and never freed, so the table holds a limited number of them;
+// when it is full, a key that is not interned is returned.
+son::key_t intern(std::string_view key);
+
+
 int32_t pretty_print(const son& value, const print_options& options = print_options());
 int32_t pretty_print(const char* fmt, const son& value, const print_options& options = print_options());
 
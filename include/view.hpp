@@ -0,0 +1,93 @@
+#ifndef SON_VIEW_HPP
+#define SON_VIEW_HPP
+
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <memory>
+#include "value.hpp"
+#include "parser.hpp"
+
+
+namespace jslavic {
+
+
+// Read-only document that is parsed on demand. Opening it finds only where the top level values are;
+// an object or array is scanned when one of its children is accessed, and what was scanned is kept.
+// Skipped objects and arrays are not lexed at all, so reading a few fields costs little even in a huge file.
+//
+// Views are cheap handles that share the document. Missing keys and indices give a view that does not exist.
+// Keys are views into the text. Strings with escape sequences are decoded when they are first read, and kept.
+// Document is not safe to access from several threads at once.
+class son_view {
+public:
+    struct document_t;
+    struct node_t;
+
+private:
+    std::shared_ptr<document_t> document;
+    node_t* node = nullptr;
+    std::string_view m_key;
+
+    son_view(std::shared_ptr<document_t> document, node_t* node, std::string_view key);
+
+public:
+    son_view() = default;
+
+    // Of the settings, max_depth and max_bytes apply. A document over max_bytes does not exist and has failed.
+    // Nesting is checked as objects and arrays are scanned, one that goes too deep makes its parent not valid.
+    static son_view open(const std::string& filename, const parser::settings_t& settings = parser::settings_t()); // Regular files are memory-mapped.
+    static son_view from_text(std::string text, const parser::settings_t& settings = parser::settings_t());
+
+    bool exists() const { return node != nullptr; }
+    bool failed() const; // Part of the document that was accessed is not valid.
+
+    son::type_t type() const;
+
+    bool is_null() const { return type() == son::type_t::null; }
+    bool is_boolean() const { return type() == son::type_t::boolean; }
+    bool is_integer() const { return type() == son::type_t::integer; }
+    bool is_floating() const { return type() == son::type_t::floating; }
+    bool is_string() const { return type() == son::type_t::string; }
+    bool is_object() const { return type() == son::type_t::object; }
+    bool is_array() const { return type() == son::type_t::array; }
+
+    bool get_boolean() const;
+    int64_t get_integer() const;
+    double get_floating() const;
+    std::string_view get_string() const;
+
+    std::string_view key() const { return m_key; } // Key in the parent object, empty otherwise.
+
+    son_view operator[](const char* key) const;
+    son_view operator[](std::string_view key) const;
+    son_view operator[](size_t idx) const;
+    son_view operator[](int32_t idx) const { return operator[](static_cast<size_t>(idx)); }
+
+    size_t size() const;
+
+    // Parses the whole subtree, without recursion.
+    son to_son() const;
+
+    struct iterator {
+        const son_view* parent = nullptr;
+        size_t idx = 0;
+
+        iterator& operator ++ () { ++idx; return *this; }
+        bool operator == (const iterator& other) const { return idx == other.idx; }
+        bool operator != (const iterator& other) const { return !(*this == other); }
+
+        son_view operator * () const { return (*parent)[idx]; }
+    };
+
+    // Children of an object or array, in order.
+    iterator begin() const { return iterator{ this, 0 }; }
+    iterator end() const { return iterator{ this, size() }; }
+};
+
+
+} // jslavic
+
+
+#endif // SON_VIEW_HPP
@@ -0,0 +1,229 @@
+#include <cursor.hpp>
+#include "lexer.hpp"
+#include "escape.hpp"
+#include <vector>
+
+
+namespace jslavic {
+
+
+struct cursor_frame {
+    kind_t closing;        // Token that ends the frame: '}', ']', or EOF at the top level.
+    bool is_object;
+    bool is_top_level;     // Sequence of values at the top level, it has no events of its own.
+};
+
+
+struct cursor::impl_t {
+    lexer lex;
+    token current;
+    std::vector<cursor_frame> frames;
+
+    kind_t kind = kind_t::none;
+    span key;
+    token value;
+    std::string unescaped; // String of the current value, if it has escape sequences.
+
+    bool started = false;
+    bool finished = false;
+    bool failed = false;
+
+    void advance() { lex.next_token(current); }
+
+    bool fail() {
+        failed = true;
+        finished = true;
+        return false;
+    }
+
+    // Separator after a value is optional: ',' in arrays and ';' in objects.
+    void eat_separator() {
+        if (frames.empty()) return;
+
+        jslavic::kind_t separator = frames.back().is_object ? TOKEN_SEMICOLON : TOKEN_COMMA;
+        if (current.kind == separator) {
+            advance();
+        }
+    }
+
+    bool start() {
+        started = true;
+        advance();
+
+        if (current.kind == TOKEN_UNDEFINED) return fail();
+
+        if (current.kind == TOKEN_IDENTIFIER) {
+            frames.push_back({ TOKEN_EOF, true, false });
+            kind = kind_t::object_begin;
+            return true;
+        }
+
+        frames.push_back({ TOKEN_EOF, false, true });
+        return next();
+    }
+
+    bool read_value() {
+        value = current;
+
+        switch (current.kind) {
+            case TOKEN_KW_NULL:     kind = kind_t::null; break;
+            case TOKEN_KW_TRUE:     kind = kind_t::boolean; break;
+            case TOKEN_KW_FALSE:    kind = kind_t::boolean; break;
+            case TOKEN_INTEGER:     kind = kind_t::integer; break;
+            case TOKEN_FLOATING:    kind = kind_t::floating; break;
+            case TOKEN_STRING:      kind = kind_t::string; break;
+            case TOKEN_BRACE_OPEN: {
+                frames.push_back({ TOKEN_BRACE_CLOSE, true, false });
+                kind = kind_t::object_begin;
+                advance();
+                return true;
+            }
+            case TOKEN_BRACKET_OPEN: {
+                frames.push_back({ TOKEN_BRACKET_CLOSE, false, false });
+                kind = kind_t::array_begin;
+                advance();
+                return true;
+            }
+            default:
+                lex.report_unexpected("value", current);
+                return fail();
+        }
+
+        advance();
+        eat_separator();
+        return true;
+    }
+
+    bool next() {
+        if (finished) return false;
+        if (not started) return start();
+
+        cursor_frame frame = frames.back();
+        key = span();
+
+        if (current.kind == frame.closing) {
+            frames.pop_back();
+
+            if (frame.is_top_level) {
+                finished = true;
+                return false;
+            }
+
+            kind = frame.is_object ? kind_t::object_end : kind_t::array_end;
+
+            // Object without braces ends with the text.
+            if (frames.empty()) {
+                finished = true;
+                return true;
+            }
+
+            advance();
+            eat_separator();
+            return true;
+        }
+
+        if (current.kind == TOKEN_EOF) {
+            lex.report_unexpected(frame.is_object ? "’}’" : "’]’", current);
+            return fail();
+        }
+
+        if (frame.is_object) {
+            if (current.kind != TOKEN_IDENTIFIER) {
+                lex.report_unexpected("identifier", current);
+                return fail();
+            }
+            key = current.in_text;
+            advance();
+
+            if (current.kind != TOKEN_EQUAL_SIGN) {
+                lex.report_unexpected("’=’", current);
+                return fail();
+            }
+            advance();
+        }
+
+        return read_value();
+    }
+
+    // Counts brackets until the one that closes the current container, without events.
+    bool skip_value() {
+        if (kind != kind_t::object_begin and kind != kind_t::array_begin) return true;
+
+        size_t depth = 0;
+        while (true) {
+            switch (current.kind) {
+                case TOKEN_BRACE_OPEN:
+                case TOKEN_BRACKET_OPEN:
+                    depth += 1;
+                    break;
+                case TOKEN_BRACE_CLOSE:
+                case TOKEN_BRACKET_CLOSE:
+                    if (depth == 0) return next();
+                    depth -= 1;
+                    break;
+                case TOKEN_EOF:
+                    if (depth == 0) return next();
+                    lex.report_unexpected("’}’ or ’]’", current);
+                    return fail();
+                case TOKEN_UNDEFINED:
+                    return fail();
+                default:
+                    break;
+            }
+            advance();
+        }
+    }
+};
+
+
+cursor::cursor(std::string_view text)
+    : impl(new impl_t())
+{
+    impl->lex.filename = "<memory>";
+    impl->lex.text = span(text.data(), text.size());
+    impl->lex.state.current_char = impl->lex.text.begin;
+}
+
+
+cursor::~cursor() = default;
+cursor::cursor(cursor&&) = default;
+cursor& cursor::operator=(cursor&&) = default;
+
+
+bool cursor::next() { return impl->next(); }
+bool cursor::skip_value() { return impl->skip_value(); }
+
+cursor::kind_t cursor::kind() const { return impl->kind; }
+std::string_view cursor::key() const { return std::string_view(impl->key.begin, impl->key.size); }
+size_t cursor::depth() const { return impl->frames.size() - (impl->frames.size() > 0 and impl->frames.front().is_top_level); }
+bool cursor::failed() const { return impl->failed or impl->lex.failed; }
+
+
+bool cursor::get_boolean() const {
+    assert(impl->kind == kind_t::boolean);
+    return impl->value.kind == TOKEN_KW_TRUE;
+}
+
+
+int64_t cursor::get_integer() const {
+    assert(impl->kind == kind_t::integer);
+    return impl->value.value.integer;
+}
+
+
+double cursor::get_floating() const {
+    assert(impl->kind == kind_t::integer or impl->kind == kind_t::floating);
+    if (impl->kind == kind_t::integer) {
+        return double(impl->value.value.integer);
+    }
+    return impl->value.value.floating;
+}
+
+
+std::string_view cursor::get_string() const {
+    assert(impl->kind == kind_t::string);
+    return decode_string(impl->value, impl->unescaped);
+}
+
+
+} // jslavic
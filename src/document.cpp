@@ -0,0 +1,49 @@
+#include <document.hpp>
+
+
+namespace jslavic {
+
+
+// First block of the arena, the next ones grow geometrically.
+static const size_t initial_arena_size = 64 * 1024;
+
+
+document::document()
+    : arena(new std::pmr::monotonic_buffer_resource(initial_arena_size))
+{}
+
+
+document::~document() = default;
+
+
+document::document(document&& other) noexcept
+    : arena(std::move(other.arena))
+    , root(std::move(other.root))
+{}
+
+
+document& document::operator=(document&& other) noexcept {
+    root = son();
+    arena = std::move(other.arena);
+    root = std::move(other.root);
+    return *this;
+}
+
+
+std::pmr::memory_resource* document::resource() {
+    if (not arena) {
+        arena.reset(new std::pmr::monotonic_buffer_resource(initial_arena_size));
+    }
+    return arena.get();
+}
+
+
+void document::clear() {
+    root = son();
+    if (arena) {
+        arena->release();
+    }
+}
+
+
+} // jslavic
@@ -0,0 +1,102 @@
+#include "escape.hpp"
+#include "simd.hpp"
+
+
+namespace jslavic {
+
+
+static uint32_t hex_value(char c) {
+    if (c >= '0' && c <= '9') return uint32_t(c - '0');
+    if (c >= 'a' && c <= 'f') return uint32_t(c - 'a' + 10);
+    return uint32_t(c - 'A' + 10);
+}
+
+
+// Reads XXXX of \uXXXX at p, which is after 'u'.
+static bool read_code_unit(const char* p, const char* end, uint32_t& code) {
+    if (end - p < 4) return false;
+
+    code = 0;
+    for (size_t i = 0; i < 4; i++) {
+        if (not is_hex_digit(p[i])) return false;
+        code = (code << 4) | hex_value(p[i]);
+    }
+    return true;
+}
+
+
+static void append_utf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += char(code);
+    } else if (code < 0x800) {
+        out += char(0xC0 | (code >> 6));
+        out += char(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += char(0xE0 | (code >> 12));
+        out += char(0x80 | ((code >> 6) & 0x3F));
+        out += char(0x80 | (code & 0x3F));
+    } else {
+        out += char(0xF0 | (code >> 18));
+        out += char(0x80 | ((code >> 12) & 0x3F));
+        out += char(0x80 | ((code >> 6) & 0x3F));
+        out += char(0x80 | (code & 0x3F));
+    }
+}
+
+
+// Runs between escapes are found in blocks and appended at once.
+// Surrogate pair in two \u escapes is one code point; a surrogate without its pair becomes U+FFFD.
+bool unescape(std::string_view raw, std::string& out) {
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+
+    while (true) {
+        const char* special = find_string_special(p, end);
+        out.append(p, special - p);
+
+        if (special == end) return true;
+        if (*special != '\\' or end - special < 2) return false;
+
+        p = special + 2;
+        switch (special[1]) {
+            case '"':  out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/'; break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case '\n': break;
+            case '\r': {
+                if (p < end and *p == '\n') p++;
+                break;
+            }
+            case 'u': {
+                uint32_t code = 0;
+                if (not read_code_unit(p, end, code)) return false;
+                p += 4;
+
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    uint32_t low = 0;
+                    if (end - p >= 6 and p[0] == '\\' and p[1] == 'u' and read_code_unit(p + 2, end, low) and low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    } else {
+                        code = 0xFFFD;
+                    }
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    code = 0xFFFD;
+                }
+
+                append_utf8(out, code);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+
+} // jslavic
@@ -0,0 +1,29 @@
+#ifndef SON_ESCAPE_HPP
+#define SON_ESCAPE_HPP
+
+#include <parser.hpp>
+#include "lexer.hpp"
+
+
+namespace jslavic {
+
+
+// Body of a string token, with escape sequences decoded. The lexer already knows if there are any:
+// most strings have none and are returned as views into the text, without another pass over them.
+// Others are decoded into buffer, which is then returned.
+inline std::string_view decode_string(const token& t, std::string& buffer) {
+    std::string_view body(t.in_text.begin + 1, t.in_text.size - 2);
+    if (not t.has_escapes) {
+        return body;
+    }
+
+    buffer.clear();
+    unescape(body, buffer);
+    return buffer;
+}
+
+
+} // jslavic
+
+
+#endif // SON_ESCAPE_HPP
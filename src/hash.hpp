@@ -0,0 +1,25 @@
+#ifndef SON_HASH_HPP
+#define SON_HASH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+
+namespace jslavic {
+
+
+// Hash of an object key, for the index of objects and the interned keys of the parser.
+inline size_t hash_key(std::string_view key) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a, keys are short.
+    for (char c : key) {
+        hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+    }
+    return size_t(hash ^ (hash >> 32));
+}
+
+
+} // jslavic
+
+
+#endif // SON_HASH_HPP
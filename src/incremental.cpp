@@ -0,0 +1,466 @@
+#include <incremental.hpp>
+#include "lexer.hpp"
+#include "escape.hpp"
+#include <deque>
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+
+namespace jslavic {
+
+
+// Collects values out of events. Every finished top level value goes to the queue.
+struct value_collector : sax_handler {
+    struct frame_t {
+        son value;
+        std::string key;
+    };
+
+    std::vector<frame_t> frames;
+    std::string key; // Key of the next value in the current object.
+    std::deque<son> values;
+
+    bool add(son&& value) {
+        if (frames.empty()) {
+            values.push_back(std::move(value));
+            return true;
+        }
+
+        son& parent = frames.back().value;
+        if (parent.is_object()) {
+            parent.push(std::move(key), std::move(value));
+        } else {
+            parent.push(std::move(value));
+        }
+
+        return true;
+    }
+
+    bool on_null() override { return add(son()); }
+    bool on_boolean(bool v) override { return add(son(v)); }
+    bool on_integer(int64_t v) override { return add(son(v)); }
+    bool on_floating(double v) override { return add(son(v)); }
+    bool on_string(std::string_view v) override { return add(son(v, std::pmr::get_default_resource())); }
+
+    bool on_key(std::string_view k) override {
+        key.assign(k.data(), k.size());
+        return true;
+    }
+
+    bool on_object_begin() override {
+        frames.push_back({ son(son::type_t::object), std::move(key) });
+        return true;
+    }
+
+    bool on_array_begin() override {
+        frames.push_back({ son(son::type_t::array), std::move(key) });
+        return true;
+    }
+
+    bool on_object_end() override { return end_container(); }
+    bool on_array_end() override { return end_container(); }
+
+    bool end_container() {
+        frame_t frame = std::move(frames.back());
+        frames.pop_back();
+
+        key = std::move(frame.key);
+        return add(std::move(frame.value));
+    }
+};
+
+
+// What the grammar expects from the next token inside of the innermost frame.
+enum expect_t {
+    EXPECT_VALUE,     // Value, or the closing token in arrays.
+    EXPECT_KEY,       // Identifier, or the closing token in objects.
+    EXPECT_EQUAL,
+    EXPECT_SEPARATOR, // Optional ',' in arrays or ';' in objects.
+};
+
+
+struct incremental_frame {
+    kind_t closing;    // Token that ends the frame: '}', ']', or EOF at the top level.
+    bool is_object;
+    bool is_top_level; // Sequence of values at the top level, it has no events of its own.
+};
+
+
+struct incremental_parser::impl_t {
+    value_collector collector;
+    sax_handler* handler = nullptr;
+
+    // Text that is not lexed yet starts at start, right after the last complete token. Text before
+    // it is erased only when it is at least half of the buffer, so it is not moved on every feed.
+    // Text that is fed in place is lexed where it is, and nothing is copied or erased.
+    std::string buffer;
+    span text; // Buffer, or text fed in place.
+    bool in_place = false;
+    size_t start = 0;
+    std::string unescaped; // Strings with escape sequences are decoded here.
+    position_t origin; // Position of text[start] in the whole stream.
+
+    // String or comment that is cut by the end of available text. Until it ends, new text is only
+    // scanned for its end from resume on, instead of lexing all of it again on every feed.
+    enum pending_t { PENDING_NONE, PENDING_STRING, PENDING_COMMENT };
+    pending_t pending = PENDING_NONE;
+    size_t resume = 0; // Offset in text.
+
+    std::vector<incremental_frame> frames;
+    expect_t expect = EXPECT_VALUE;
+
+    bool started = false;
+    bool finished = false;
+    bool failed = false;
+
+    bool fail() {
+        failed = true;
+        return false;
+    }
+
+    bool close_frame() {
+        incremental_frame frame = frames.back();
+        frames.pop_back();
+
+        if (frame.is_top_level) {
+            finished = true;
+            return true;
+        }
+
+        bool successful = frame.is_object ? handler->on_object_end() : handler->on_array_end();
+
+        // Object without braces ends with the text.
+        if (frames.empty()) {
+            finished = true;
+        }
+
+        expect = EXPECT_SEPARATOR;
+        return successful;
+    }
+
+    bool take_value(lexer& lex, const token& t) {
+        expect = EXPECT_SEPARATOR;
+
+        switch (t.kind) {
+            case TOKEN_KW_NULL:  return handler->on_null();
+            case TOKEN_KW_TRUE:  return handler->on_boolean(true);
+            case TOKEN_KW_FALSE: return handler->on_boolean(false);
+            case TOKEN_INTEGER:  return handler->on_integer(t.value.integer);
+            case TOKEN_FLOATING: return handler->on_floating(t.value.floating);
+            case TOKEN_STRING:   return handler->on_string(decode_string(t, unescaped));
+            case TOKEN_BRACE_OPEN: {
+                frames.push_back({ TOKEN_BRACE_CLOSE, true, false });
+                expect = EXPECT_KEY;
+                return handler->on_object_begin();
+            }
+            case TOKEN_BRACKET_OPEN: {
+                frames.push_back({ TOKEN_BRACKET_CLOSE, false, false });
+                expect = EXPECT_VALUE;
+                return handler->on_array_begin();
+            }
+            default:
+                lex.report_unexpected("value", t);
+                return false;
+        }
+    }
+
+    // Grammar of the parser turned inside out: it is driven by tokens one at a time,
+    // so it can stop between any two of them and wait for more input.
+    bool take_token(lexer& lex, const token& t) {
+        if (finished) {
+            return false;
+        }
+
+        if (not started) {
+            started = true;
+
+            if (t.kind == TOKEN_IDENTIFIER) {
+                frames.push_back({ TOKEN_EOF, true, false });
+                expect = EXPECT_KEY;
+                if (not handler->on_object_begin()) return false;
+            } else {
+                frames.push_back({ TOKEN_EOF, false, true });
+                expect = EXPECT_VALUE;
+            }
+        }
+
+        const incremental_frame& frame = frames.back();
+
+        if (expect == EXPECT_SEPARATOR) {
+            kind_t separator = frame.is_object ? TOKEN_SEMICOLON : TOKEN_COMMA;
+            expect = frame.is_object ? EXPECT_KEY : EXPECT_VALUE;
+
+            if (t.kind == separator) {
+                return true;
+            }
+        }
+
+        switch (expect) {
+            case EXPECT_KEY: {
+                if (t.kind == frame.closing) {
+                    return close_frame();
+                }
+
+                if (t.kind != TOKEN_IDENTIFIER) {
+                    lex.report_unexpected(t.kind == TOKEN_EOF ? "’}’" : "identifier", t);
+                    return false;
+                }
+
+                expect = EXPECT_EQUAL;
+                return handler->on_key(std::string_view(t.in_text.begin, t.in_text.size));
+            }
+            case EXPECT_EQUAL: {
+                if (t.kind != TOKEN_EQUAL_SIGN) {
+                    lex.report_unexpected("’=’", t);
+                    return false;
+                }
+
+                expect = EXPECT_VALUE;
+                return true;
+            }
+            case EXPECT_VALUE: {
+                if (not frame.is_object and t.kind == frame.closing) {
+                    return close_frame();
+                }
+                if (not frame.is_object and t.kind == TOKEN_EOF) {
+                    lex.report_unexpected("’]’", t);
+                    return false;
+                }
+
+                return take_value(lex, t);
+            }
+            default:
+                return false;
+        }
+    }
+
+    // Goes on through a quoted string from p, which is inside of it. Returns where the scan goes on
+    // when there is more text: end, or an escape sequence that end cuts. Returns nullptr if the
+    // string ends, or is broken, before end.
+    static const char* string_cut_at(const char* p, const char* end) {
+        while (true) {
+            p = find_string_special(p, end);
+            if (p == end) return end;
+            if (*p != '\\') return nullptr; // '"', line break or 0.
+
+            size_t length = 0;
+            escape_status status = scan_escape(p, end, length);
+            if (status == escape_status::invalid) return nullptr;
+            if (status == escape_status::cut) return p;
+            p += length;
+        }
+    }
+
+    // Scans only the new text after a cut string or comment. True if it ends there, so that
+    // everything is lexed again, or if there is nothing pending.
+    bool pending_ends() {
+        const char* end = text.begin + text.size;
+        const char* p = text.begin + resume;
+
+        switch (pending) {
+            case PENDING_NONE:
+                return true;
+            case PENDING_COMMENT:
+                if (find_newline(p, end) < end) return true;
+                resume = text.size;
+                return false;
+            case PENDING_STRING:
+                p = string_cut_at(p, end);
+                if (not p) return true;
+                resume = p - text.begin;
+                return false;
+        }
+
+        return true;
+    }
+
+    // Lexes and parses all tokens that are surely complete. Text is lexed only up to the last space
+    // or punctuation character, so identifiers and numbers are never cut. Strings and comments
+    // may still be cut: then the text from the start of the unfinished part is kept.
+    bool process(bool last) {
+        if (not last and not pending_ends()) {
+            return true;
+        }
+        pending = PENDING_NONE;
+
+        size_t size = text.size;
+
+        if (not last) {
+            while (size > start) {
+                // Quotes and "//" also end it, so the start of a long string or comment is found
+                // without going back through all of it.
+                uint8_t c = char_classes[(uint8_t)text.begin[size - 1]];
+                if (c == CHAR_SPACE or c == CHAR_PUNCTUATION or c == CHAR_QUOTE) break;
+                if (c == CHAR_SLASH and size - start >= 2 and text.begin[size - 2] == '/') break;
+                size -= 1;
+            }
+
+            if (size == start) {
+                return true;
+            }
+        }
+
+        lexer lex;
+        lex.filename = "<stream>";
+        lex.text = span(text.begin + start, size - start);
+        lex.state.current_char = lex.text.begin;
+        lex.origin = origin;
+
+        lexer::state_t rest = lex.get_checkpoint();
+        const char* end = text.begin + size;
+
+        token t;
+        while (true) {
+            // Cut strings are not errors yet, they are reported when they are lexed with the rest.
+            lex.quiet = not last;
+            lex.next_token(t);
+            lex.quiet = false;
+
+            if (t.kind == TOKEN_UNDEFINED) {
+                const char* p = lex.state.current_char;
+                const char* resume_at = (last or p == end or *p != '"') ? nullptr : string_cut_at(p + 1, end);
+                if (not resume_at) {
+                    if (not last) {
+                        lex.state = rest;
+                        lex.next_token(t); // Again, to report the error.
+                    }
+                    return fail();
+                }
+
+                rest = lex.get_checkpoint();
+                pending = PENDING_STRING;
+                resume = resume_at - text.begin;
+                break;
+            }
+
+            if (t.kind == TOKEN_EOF and not last) {
+                // Spaces and comments after the last token are lexed again with more text. If the last
+                // line has a comment, it is not finished, and only its end is looked for until then.
+                const char* line = rest.current_char;
+                for (const char* newline = find_newline(line, end); newline < end; newline = find_newline(line, end)) {
+                    line = newline + 1;
+                }
+
+                if (memchr(line, '/', end - line)) {
+                    pending = PENDING_COMMENT;
+                    resume = size;
+                }
+                break;
+            }
+
+            if (not take_token(lex, t)) {
+                return fail();
+            }
+
+            rest = lex.get_checkpoint();
+
+            if (t.kind == TOKEN_EOF) {
+                break;
+            }
+        }
+
+        origin = lex.position(rest.current_char);
+        start = rest.current_char - text.begin;
+
+        if (not in_place and start * 2 >= buffer.size()) {
+            buffer.erase(0, start);
+            text = span(buffer.data(), buffer.size());
+            resume -= std::min(resume, start);
+            start = 0;
+        }
+
+        return true;
+    }
+};
+
+
+incremental_parser::incremental_parser()
+    : impl(new impl_t())
+{
+    impl->handler = &impl->collector;
+}
+
+
+incremental_parser::incremental_parser(sax_handler& handler)
+    : impl(new impl_t())
+{
+    impl->handler = &handler;
+}
+
+
+incremental_parser::~incremental_parser() = default;
+incremental_parser::incremental_parser(incremental_parser&&) = default;
+incremental_parser& incremental_parser::operator=(incremental_parser&&) = default;
+
+
+bool incremental_parser::feed(const char* data, size_t size) {
+    if (impl->failed) {
+        return false;
+    }
+
+    // Text that was fed in place and is not parsed yet moves into the buffer.
+    if (impl->in_place) {
+        impl->buffer.assign(impl->text.begin + impl->start, impl->text.size - impl->start);
+        impl->resume -= std::min(impl->resume, impl->start);
+        impl->start = 0;
+        impl->in_place = false;
+    }
+
+    impl->buffer.append(data, size);
+    impl->text = span(impl->buffer.data(), impl->buffer.size());
+    return impl->process(false);
+}
+
+
+bool incremental_parser::feed_in_place(const char* data, size_t size) {
+    if (impl->failed) {
+        return false;
+    }
+
+    if (not impl->in_place and impl->start < impl->buffer.size()) {
+        return feed(data, size);
+    }
+
+    if (impl->in_place) {
+        assert(data == impl->text.begin + impl->text.size);
+        impl->text.size += size;
+    } else {
+        impl->buffer.clear();
+        impl->text = span(data, size);
+        impl->start = 0;
+        impl->resume = 0;
+        impl->in_place = true;
+    }
+
+    return impl->process(false);
+}
+
+
+bool incremental_parser::finish() {
+    if (impl->failed) {
+        return false;
+    }
+
+    return impl->process(true);
+}
+
+
+bool incremental_parser::next_value(son& value) {
+    auto& values = impl->collector.values;
+    if (values.empty()) {
+        return false;
+    }
+
+    value = std::move(values.front());
+    values.pop_front();
+    return true;
+}
+
+
+bool incremental_parser::failed() const {
+    return impl->failed;
+}
+
+
+} // jslavic
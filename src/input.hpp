@@ -0,0 +1,158 @@
+#ifndef SON_INPUT_HPP
+#define SON_INPUT_HPP
+
+#include "lexer.hpp"
+#include <stdio.h>
+#include <string>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SON_HAS_MMAP
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace jslavic {
+
+
+// Text of the input file. Regular files are memory-mapped and lexed in place, anything else
+// (pipes, character devices) is read into the buffer in one pass by open(), or in chunks with
+// open_file() and read_some(), when it is streamed.
+struct input_text {
+    span text;
+    std::string& buffer;
+
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+
+#ifdef SON_HAS_MMAP
+    int descriptor = -1; // File that is read, not mapped.
+#else
+    FILE* file = nullptr;
+#endif
+    size_t size_hint = 0; // Size of a regular file that is read.
+
+    // Files at least this big are hinted to be backed by huge pages.
+    static constexpr size_t huge_page_threshold = 2 * 1024 * 1024;
+
+    input_text(std::string& buffer) : buffer(buffer) {}
+    input_text(const input_text&) = delete;
+    input_text& operator=(const input_text&) = delete;
+
+    ~input_text() {
+#ifdef SON_HAS_MMAP
+        if (mapping) { munmap(mapping, mapping_size); }
+#endif
+        close_file();
+    }
+
+    // Opens the file and maps it when it is regular and use_mmap is set. Otherwise it is read with read_some().
+    bool open_file(const char* filename, bool use_mmap) {
+        text = span(buffer.data(), 0);
+
+#ifdef SON_HAS_MMAP
+        int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { return false; }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+
+        if (use_mmap and S_ISREG(st.st_mode)) {
+            if (st.st_size == 0) {
+                close(fd);
+                return true;
+            }
+
+            size_t size = static_cast<size_t>(st.st_size);
+            void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                close(fd);
+
+                madvise(p, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+                if (size >= huge_page_threshold) { madvise(p, size, MADV_HUGEPAGE); }
+#endif
+                mapping = p;
+                mapping_size = size;
+                text = span((const char*)p, size);
+                return true;
+            }
+            // Could not map, fall back to reading.
+        }
+
+        descriptor = fd;
+        size_hint = S_ISREG(st.st_mode) ? static_cast<size_t>(st.st_size) : 0;
+        return true;
+#else
+        (void)use_mmap;
+        file = fopen(filename, "rb");
+        return file != nullptr;
+#endif
+    }
+
+    // Reads the next bytes of a file that is not mapped. Returns 0 at the end of it, and -1 on error.
+    long read_some(char* p, size_t size) {
+#ifdef SON_HAS_MMAP
+        if (descriptor < 0) { return 0; }
+
+        while (true) {
+            ssize_t n = read(descriptor, p, size);
+            if (n < 0 and errno == EINTR) { continue; }
+            return n;
+        }
+#else
+        if (not file) { return 0; }
+
+        size_t n = fread(p, 1, size, file);
+        return (n == 0 and ferror(file)) ? -1 : long(n);
+#endif
+    }
+
+    void close_file() {
+#ifdef SON_HAS_MMAP
+        if (descriptor >= 0) { close(descriptor); }
+        descriptor = -1;
+#else
+        if (file) { fclose(file); }
+        file = nullptr;
+#endif
+    }
+
+    // Input that is read stops as soon as it is longer than max_bytes, if it is not 0. Then the text
+    // is cut, but still longer than max_bytes, so the caller can tell that it is too long.
+    bool open(const char* filename, bool use_mmap, size_t max_bytes = 0) {
+        if (not open_file(filename, use_mmap)) { return false; }
+        if (mapping) { return true; }
+
+        buffer.clear();
+        buffer.reserve(max_bytes != 0 ? std::min(size_hint, max_bytes + 1) : size_hint);
+
+        char chunk[64 * 1024];
+        while (max_bytes == 0 or buffer.size() <= max_bytes) {
+            long n = read_some(chunk, sizeof(chunk));
+            if (n < 0) {
+                close_file();
+                return false;
+            }
+            if (n == 0) { break; }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+
+        close_file();
+        text = span(buffer.data(), buffer.size());
+        return true;
+    }
+};
+
+
+} // jslavic
+
+
+#endif // SON_INPUT_HPP
@@ -0,0 +1,667 @@
+#ifndef SON_LEXER_HPP
+#define SON_LEXER_HPP
+
+#include "simd.hpp"
+#include "number.hpp"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <string>
+#include <algorithm>
+
+
+namespace jslavic {
+
+
+enum kind_t {
+    TOKEN_UNDEFINED = 0,
+
+    TOKEN_EQUAL_SIGN = '=',
+    TOKEN_SEMICOLON = ';',
+    TOKEN_COMMA = ',',
+
+    TOKEN_BRACE_OPEN = '{',
+    TOKEN_BRACE_CLOSE = '}',
+
+    TOKEN_PAREN_OPEN = '(',
+    TOKEN_PAREN_CLOSE = ')',
+
+    TOKEN_BRACKET_OPEN = '[',
+    TOKEN_BRACKET_CLOSE = ']',
+
+    TOKEN_KW_NULL = 256,
+    TOKEN_KW_TRUE,
+    TOKEN_KW_FALSE,
+
+    TOKEN_IDENTIFIER,
+    TOKEN_INTEGER,
+    TOKEN_FLOATING,
+    TOKEN_STRING,
+
+    TOKEN_DOUBLE_SLASH,
+
+    TOKEN_EOF,
+};
+
+
+// static const char* to_debug_string(kind_t k) {
+//     switch (k) {
+//         case TOKEN_UNDEFINED:     return "TOKEN_UNDEFINED";
+
+//         case TOKEN_EQUAL_SIGN:    return "TOKEN_EQUAL_SIGN";
+//         case TOKEN_SEMICOLON:     return "TOKEN_SEMICOLON";
+//         case TOKEN_COMMA:         return "TOKEN_COMMA";
+
+//         case TOKEN_BRACE_OPEN:    return "TOKEN_BRACE_OPEN";
+//         case TOKEN_BRACE_CLOSE:   return "TOKEN_BRACE_CLOSE";
+
+//         case TOKEN_PAREN_OPEN:    return "TOKEN_PAREN_OPEN";
+//         case TOKEN_PAREN_CLOSE:   return "TOKEN_PAREN_CLOSE";
+
+//         case TOKEN_BRACKET_OPEN:  return "TOKEN_BRACKET_OPEN";
+//         case TOKEN_BRACKET_CLOSE: return "TOKEN_BRACKET_CLOSE";
+
+//         case TOKEN_KW_NULL:       return "TOKEN_KW_NULL";
+//         case TOKEN_KW_TRUE:       return "TOKEN_KW_TRUE";
+//         case TOKEN_KW_FALSE:      return "TOKEN_KW_FALSE";
+
+//         case TOKEN_IDENTIFIER:    return "TOKEN_IDENTIFIER";
+//         case TOKEN_INTEGER:       return "TOKEN_INTEGER";
+//         case TOKEN_FLOATING:      return "TOKEN_FLOATING";
+//         case TOKEN_STRING:        return "TOKEN_STRING";
+
+//         case TOKEN_DOUBLE_SLASH:  return "TOKEN_DOUBLE_SLASH";
+
+//         case TOKEN_EOF:           return "TOKEN_EOF";
+//     }
+
+//     return "ERROR";
+// }
+
+
+// Name of a kind of token for error messages.
+static inline const char* to_string(kind_t k) {
+    switch (k) {
+        case TOKEN_UNDEFINED:     return "? undefined";
+
+        case TOKEN_EQUAL_SIGN:    return "=";
+        case TOKEN_SEMICOLON:     return ";";
+        case TOKEN_COMMA:         return ",";
+
+        case TOKEN_BRACE_OPEN:    return "{";
+        case TOKEN_BRACE_CLOSE:   return "}";
+
+        case TOKEN_PAREN_OPEN:    return "(";
+        case TOKEN_PAREN_CLOSE:   return ")";
+
+        case TOKEN_BRACKET_OPEN:  return "[";
+        case TOKEN_BRACKET_CLOSE: return "]";
+
+        case TOKEN_KW_NULL:       return "null";
+        case TOKEN_KW_TRUE:       return "true";
+        case TOKEN_KW_FALSE:      return "false";
+
+        case TOKEN_IDENTIFIER:    return "identifier";
+        case TOKEN_INTEGER:       return "integer";
+        case TOKEN_FLOATING:      return "floating";
+        case TOKEN_STRING:        return "string";
+
+        case TOKEN_DOUBLE_SLASH:  return "//";
+
+        case TOKEN_EOF:           return "EOF";
+    }
+
+    return "ERROR";
+}
+
+
+struct span {
+    const char* begin = nullptr;
+    size_t size = 0;
+
+    span() : begin(nullptr), size(0) {}
+    span(const char* begin, size_t size) : begin(begin), size(size) {}
+
+    operator bool () { return size > 0; }
+};
+
+
+struct token {
+    union value_t {
+        int64_t integer;
+        double floating;
+    };
+
+    value_t value;
+    kind_t kind;
+    bool has_escapes = false; // String has escape sequences, see decode_string.
+
+    // Where the token is in the text. Line and column are found from it only for errors, see lexer::position.
+    span in_text;
+};
+
+
+// void print_token(token t) {
+//     printf("token { kind = %20s; value = ", to_debug_string(t.kind));
+
+//     switch (t.kind) {
+//         case TOKEN_UNDEFINED: printf("ERROR! }\n"); break;
+//         case TOKEN_EOF:       printf("EOF; }\n"); break;
+//         case TOKEN_KW_NULL:   printf("null; }\n"); break;
+//         case TOKEN_KW_TRUE:   printf("true; }\n"); break;
+//         case TOKEN_KW_FALSE:  printf("false; }\n"); break;
+//         case TOKEN_INTEGER:   printf(PRId64"; }\n", t.value.integer); break;
+//         case TOKEN_FLOATING:  printf("%lf; }\n", t.value.floating); break;
+
+//         case TOKEN_IDENTIFIER:
+//         case TOKEN_STRING:
+//             printf("%.*s; }\n", int(t.in_text.size), t.in_text.begin);
+//             break;
+
+//         case TOKEN_EQUAL_SIGN:
+//         case TOKEN_SEMICOLON:
+//         case TOKEN_COMMA:
+//         case TOKEN_BRACE_OPEN:
+//         case TOKEN_BRACE_CLOSE:
+//         case TOKEN_PAREN_OPEN:
+//         case TOKEN_PAREN_CLOSE:
+//         case TOKEN_BRACKET_OPEN:
+//         case TOKEN_BRACKET_CLOSE:
+//             printf("'%c'; }\n", char(t.kind));
+//             break;
+
+//         case TOKEN_DOUBLE_SLASH:
+//             printf("//; }\n");
+//             break;
+//         default:
+//             printf("??? }\n");
+//     }
+// }
+
+
+
+typedef bool(*predicate_t)(char);
+
+// predicates
+static constexpr bool is_alpha (char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+static constexpr bool is_digit (char c ) { return c >= '0' && c <= '9'; }
+static constexpr bool is_newline (char c) { return c == '\n' || c == '\r'; }
+static constexpr bool is_space (char c) { return c == ' ' || c == '\t' || is_newline(c); }
+static constexpr bool is_valid_identifier_head (char c) { return is_alpha(c) || c == '_'; }
+static constexpr bool is_valid_identifier_body (char c) { return is_digit(c) || is_alpha(c) || c == '_'; }
+static constexpr bool is_hex_digit (char c) { return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+
+// Escape sequences in quoted strings: \" \\ \/ \b \f \n \r \t, \uXXXX with four hex digits,
+// and a backslash right before a line break, which continues the string on the next line without the break.
+enum class escape_status {
+    ok,
+    cut,     // Text ends inside of the sequence, more text may complete it.
+    invalid,
+};
+
+
+// Length of the escape sequence at p (a backslash) if only its end is needed.
+static inline size_t escape_skip(const char* p, const char* end) {
+    return (end - p >= 3 && p[1] == '\r' && p[2] == '\n') ? 3 : 2;
+}
+
+
+// Checks the escape sequence at p, which is a backslash. Length is set for valid and invalid ones.
+static inline escape_status scan_escape(const char* p, const char* end, size_t& length) {
+    if (end - p < 2) return escape_status::cut;
+
+    switch (p[1]) {
+        case '"': case '\\': case '/':
+        case 'b': case 'f': case 'n': case 'r': case 't':
+        case '\n': case '\r':
+            length = escape_skip(p, end);
+            return escape_status::ok;
+        case 'u':
+            for (size_t i = 2; i < 6; i++) {
+                if (p + i == end) return escape_status::cut;
+                if (not is_hex_digit(p[i])) {
+                    length = is_newline(p[i]) ? i : i + 1;
+                    return escape_status::invalid;
+                }
+            }
+            length = 6;
+            return escape_status::ok;
+        default:
+            length = 2;
+            return escape_status::invalid;
+    }
+}
+
+// Keywords are recognized on the span itself, without making a string out of it.
+static inline kind_t keyword_or_identifier(const char* s, size_t n) {
+    switch (n) {
+        case 4:
+            if (memcmp(s, "null", 4) == 0) return TOKEN_KW_NULL;
+            if (memcmp(s, "true", 4) == 0) return TOKEN_KW_TRUE;
+            break;
+        case 5:
+            if (memcmp(s, "false", 5) == 0) return TOKEN_KW_FALSE;
+            break;
+    }
+
+    return TOKEN_IDENTIFIER;
+}
+
+enum char_class_t : uint8_t {
+    CHAR_OTHER = 0,
+    CHAR_SPACE,
+    CHAR_PUNCTUATION, // Characters that are tokens on their own.
+    CHAR_SLASH,
+    CHAR_QUOTE,
+    CHAR_NUMBER,      // Digits, '.', '+' and '-'.
+    CHAR_IDENTIFIER,  // Letters and '_'.
+};
+
+struct char_class_table {
+    uint8_t classes[256];
+
+    constexpr char_class_table() : classes() {
+        for (int c = 0; c < 256; c++) {
+            char ch = char(c);
+
+            if (is_space(ch)) classes[c] = CHAR_SPACE;
+            else if (is_digit(ch) || ch == '.' || ch == '+' || ch == '-') classes[c] = CHAR_NUMBER;
+            else if (is_valid_identifier_head(ch)) classes[c] = CHAR_IDENTIFIER;
+            else if (ch == '/') classes[c] = CHAR_SLASH;
+            else if (ch == '"') classes[c] = CHAR_QUOTE;
+            else if (ch == '{' || ch == '}' || ch == '(' || ch == ')' || ch == '[' || ch == ']' ||
+                     ch == '=' || ch == ';' || ch == ',') classes[c] = CHAR_PUNCTUATION;
+        }
+    }
+
+    constexpr uint8_t operator[](uint8_t c) const { return classes[c]; }
+};
+
+static constexpr char_class_table char_classes;
+
+// static strings 50 characters each
+// static const char* spaces = "                                                                         ";
+// static const char* carets = "^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^";
+
+
+struct position_t {
+    size_t line = 1;
+    size_t column = 1;
+};
+
+
+struct lexer {
+    const char* filename = nullptr;
+    span text;
+    position_t origin; // Position of the first character of text, if it is not the start of a file.
+    const char* file_begin = nullptr; // Start of the file, when text is a part of it in memory.
+
+    struct state_t {
+        const char* current_char = nullptr;
+    };
+
+    state_t state;
+    bool failed = false;
+    bool quiet = false; // Do not report errors, e.g. when the text is parsed again to report them.
+    bool validate_utf8 = false; // Strings have to be valid UTF-8.
+    std::string* errors = nullptr; // Errors are appended here if it is set, otherwise printed.
+
+public:
+    template <typename... Args>
+    void report(const char* format, Args... args) {
+        if (quiet) {
+            return;
+        }
+
+        if (not errors) {
+            printf(format, args...);
+            return;
+        }
+
+        char message[512];
+        int length = snprintf(message, sizeof(message), format, args...);
+        if (length > 0) {
+            errors->append(message, std::min(size_t(length), sizeof(message) - 1));
+        }
+    }
+
+    // Reports a token that the grammar does not expect there, e.g. expected = "’=’".
+    // Tokens that could not be lexed were reported by the lexer already.
+    void report_unexpected(const char* expected, const token& t) {
+        if (t.kind == TOKEN_UNDEFINED) {
+            return;
+        }
+
+        position_t where = position(t.in_text.begin);
+        report("%s:%lu:%lu: error: expected %s, but found %s ’%.*s’\n",
+            filename, where.line, where.column, expected, to_string(t.kind), (int)t.in_text.size, t.in_text.begin);
+    }
+
+    // Line and column of a character in text. Nothing is counted while lexing; lines are counted
+    // here, only when an error is reported. "\r\n" is one line break, same as '\n' or '\r' alone.
+    position_t position(const char* p) const {
+        position_t result = origin;
+        const char* line = file_begin ? file_begin : text.begin;
+        const char* newline = find_newline(line, p);
+
+        while (newline < p) {
+            bool is_crlf = (newline[0] == '\r' and newline + 1 < text.begin + text.size and newline[1] == '\n');
+            if (not is_crlf) {
+                result.line += 1;
+                result.column = 1;
+                line = newline + 1;
+            }
+            newline = find_newline(newline + 1, p);
+        }
+
+        result.column += p - line;
+        return result;
+    }
+
+    // Byte offset of a character from the start of the file.
+    size_t offset(const char* p) const {
+        return p - (file_begin ? file_begin : text.begin);
+    }
+
+    state_t get_checkpoint() const { return state; }
+    void restore_checkpoint(state_t checkpoint) { state = checkpoint; }
+
+    inline char get_char () {
+        assert(state.current_char);
+
+        if (state.current_char == text.begin + text.size) return 0;
+
+        return *state.current_char;
+    }
+
+    inline char eat_char () {
+        char c = get_char();
+        state.current_char++;
+        return c;
+    }
+
+    span eat_while(predicate_t predicate) {
+        auto checkpoint = get_checkpoint();
+        size_t count = 0;
+
+        char c;
+        while (true) {
+            c = get_char();
+
+            if (c == 0 || not predicate(c)) { break; }
+
+            eat_char();
+            count += 1;
+        }
+
+        return span(checkpoint.current_char, count);
+    }
+
+    span eat_until(predicate_t predicate) {
+        auto checkpoint = get_checkpoint();
+        size_t count = 0;
+
+        char c;
+        while (true) {
+            c = get_char();
+
+            if (c == 0 || predicate(c)) { break; }
+
+            eat_char();
+            count += 1;
+        }
+
+        return span(checkpoint.current_char, count);
+    }
+
+    span eat_string(const char* str, size_t n) {
+        auto checkpoint = get_checkpoint();
+        size_t count = 0;
+
+        while (count < n) {
+            char c = get_char();
+
+            if ((c == 0) || (c != str[count])) {
+                restore_checkpoint(checkpoint);
+                return span();
+            }
+
+            eat_char();
+            count += 1;
+        }
+
+        return span(checkpoint.current_char, count);
+    }
+
+    span eat_string(const char* str) {
+        auto checkpoint = get_checkpoint();
+        size_t count = 0;
+
+        while (str[count]) {
+            char c = get_char();
+
+            if ((c == 0) || (c != str[count])) {
+                restore_checkpoint(checkpoint);
+                return span();
+            }
+
+            eat_char();
+            count += 1;
+        }
+
+        return span(checkpoint.current_char, count);
+    }
+
+    // Skips a run of spaces in blocks.
+    inline void skip_spaces() {
+        const char* end = text.begin + text.size;
+        if (state.current_char == end or char_classes[(uint8_t)*state.current_char] != CHAR_SPACE) {
+            return;
+        }
+
+        state.current_char = jslavic::skip_spaces(state.current_char, end);
+    }
+
+    // Lexes exactly one token starting at the current position, skipping spaces and comments before it.
+    // There is no token stream: the parser pulls tokens one at a time, so memory does not depend on input size.
+    // On error the token is TOKEN_UNDEFINED and the lexer is marked as failed.
+    bool next_token(token& t) {
+        bool successful = next_token_impl(t);
+        if (not successful) {
+            t.kind = TOKEN_UNDEFINED;
+            failed = true;
+        }
+        return successful;
+    }
+
+    bool next_token_impl(token& t) {
+        char c;
+        while (skip_spaces(), (c = get_char()) != 0) {
+            switch (char_classes[(uint8_t)c]) {
+            case CHAR_PUNCTUATION: {
+                t.in_text.begin = state.current_char;
+                t.in_text.size = 1;
+                t.kind = kind_t(c);
+                t.value.integer = 0;
+
+                eat_char();
+                return true;
+            }
+            case CHAR_SLASH: {
+                if (not eat_string("//")) break;
+
+                state.current_char = find_newline(state.current_char, text.begin + text.size);
+                continue;
+            }
+            case CHAR_QUOTE:
+                return eat_quoted_string(t);
+            case CHAR_NUMBER: // Read number, integer or float is unknown.
+                return eat_number(t);
+            case CHAR_IDENTIFIER:
+                return eat_keyword_or_identifier(t);
+            }
+
+            {
+                auto checkpoint = get_checkpoint();
+                auto result = eat_until(is_space);
+
+                position_t where = position(checkpoint.current_char);
+                report("%s:%lu:%lu: error: unknown lexeme ’%.*s’\n", filename, where.line, where.column, (int)result.size, result.begin);
+
+                // auto line = get_line();
+                // printf("   %lu | %.*s\n", checkpoint.line_counter, (int)line.length, line.start);
+                // printf("   %.*s | %.*s%.*s\n",
+                //     (int)(digits_in_number(checkpoint.line_counter)), spaces,
+                //     (int)(checkpoint.current - line.start), spaces,
+                //     (int)result.length, carets);
+
+                // printf("Parse Error! Unknown lexeme: %.*s\n", i32(result.length), result.start);
+                return false;
+            }
+        }
+
+        t.in_text.begin = state.current_char;
+        t.in_text.size = 1;
+        t.kind = TOKEN_EOF;
+        t.value.integer = 0;
+
+        return true;
+    }
+
+    // Token spans the string as it is in the text, escape sequences are only checked here. See decode_string.
+    bool eat_quoted_string (token& t) {
+        auto checkpoint = get_checkpoint();
+        uint64_t length = 0;
+        bool has_escapes = false;
+
+        char c = get_char();
+        if (c != '"') {
+            // No characters are eated yet. Return as normal.
+            return false;
+        }
+
+        eat_char(); // Skip double quote.
+        length += 1;
+
+        const char* end = text.begin + text.size;
+        while (true) {
+            // Jump over the plain run in blocks. Multibyte sequences have no ASCII bytes, so the run
+            // ends between them and is validated on its own while it is still in cache.
+            const char* special = find_string_special(state.current_char, end);
+            if (validate_utf8) {
+                const char* invalid = find_invalid_utf8(state.current_char, special);
+                if (invalid != special) {
+                    position_t where = position(invalid);
+                    report("%s:%lu:%lu: error: string is not valid UTF-8 at byte %lu\n", filename, where.line, where.column, offset(invalid));
+                    restore_checkpoint(checkpoint);
+                    return false;
+                }
+            }
+            length += special - state.current_char;
+            state.current_char = special;
+
+            c = get_char();
+            if (c == '"') break;
+
+            if (c == '\\') {
+                size_t escape_length = 0;
+                escape_status status = scan_escape(state.current_char, end, escape_length);
+
+                if (status == escape_status::invalid) {
+                    position_t where = position(state.current_char);
+                    report("%s:%lu:%lu: error: unknown escape sequence ’%.*s’\n", filename, where.line, where.column, (int)escape_length, state.current_char);
+                    restore_checkpoint(checkpoint);
+                    return false;
+                }
+
+                if (status == escape_status::ok) {
+                    state.current_char += escape_length;
+                    length += escape_length;
+                    has_escapes = true;
+                    continue;
+                }
+
+                // Cut by the end of text, same as a string that is not closed.
+            }
+
+            // Newlines are not allowed to intercept string.
+            restore_checkpoint(checkpoint);
+
+            position_t where = position(checkpoint.current_char);
+            report("%s:%lu:%lu: error: unclosed double quote\n", filename, where.line, where.column);
+            return false;
+        }
+
+        eat_char(); // Skip double quote.
+        length += 1;
+
+        t.in_text.begin = checkpoint.current_char;
+        t.in_text.size = length;
+        t.kind = TOKEN_STRING;
+        t.value.integer = 0;
+        t.has_escapes = has_escapes;
+
+        return true;
+    }
+
+    bool eat_keyword_or_identifier (token& t) {
+        char c = get_char();
+
+        if (!is_valid_identifier_head(c)) {
+            return false;
+        }
+
+        // This have to eat at least one symbol.
+        const char* p = state.current_char + 1;
+        const char* end = text.begin + text.size;
+        while (p < end and is_valid_identifier_body(*p)) { p++; }
+
+        t.in_text = span(state.current_char, p - state.current_char);
+        t.value.integer = 0;
+        t.kind = keyword_or_identifier(t.in_text.begin, t.in_text.size);
+
+        state.current_char = p;
+
+        return true;
+    }
+
+    bool eat_number (token& t) {
+        auto checkpoint = get_checkpoint();
+
+        number n;
+        number_status status = scan_number(state.current_char, text.begin + text.size, n);
+
+        if (status != number_status::ok) {
+            auto result = span(checkpoint.current_char, (n.end > checkpoint.current_char) ? (n.end - checkpoint.current_char) : 1);
+            position_t where = position(checkpoint.current_char);
+            if (status == number_status::out_of_range) {
+                report("%s:%lu:%lu: error: number ’%.*s’ is out of range\n", filename, where.line, where.column, (int)result.size, result.begin);
+            } else {
+                report("%s:%lu:%lu: error: expected digits in number ’%.*s’\n", filename, where.line, where.column, (int)result.size, result.begin);
+            }
+            return false;
+        }
+
+        t.in_text.begin = checkpoint.current_char;
+        t.in_text.size = n.end - checkpoint.current_char;
+        state.current_char = n.end;
+
+        if (n.is_floating) {
+            t.kind = TOKEN_FLOATING;
+            t.value.floating = n.floating;
+        } else {
+            t.kind = TOKEN_INTEGER;
+            t.value.integer = n.integer;
+        }
+
+        return true;
+    }
+};
+
+
+} // jslavic
+
+
+#endif // SON_LEXER_HPP
@@ -0,0 +1,233 @@
+#include "number.hpp"
+#include <string.h>
+#include <version>
+
+#ifdef __cpp_lib_to_chars
+#include <charconv>
+#else
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+#include <string>
+#endif
+
+
+namespace jslavic {
+
+
+static inline bool is_digit_byte(char c) { return c >= '0' && c <= '9'; }
+
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SON_SWAR_DIGITS
+#endif
+
+
+#ifdef SON_SWAR_DIGITS
+
+// Eight ASCII digits are handled as one little-endian 64-bit word.
+
+static inline uint64_t load_eight(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline bool is_eight_digits(uint64_t v) {
+    return (((v & 0xF0F0F0F0F0F0F0F0) | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333);
+}
+
+static inline uint32_t parse_eight_digits(uint64_t v) {
+    const uint64_t mask = 0x000000FF000000FF;
+    const uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+
+    v -= 0x3030303030303030;
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return uint32_t(v);
+}
+
+#endif // SON_SWAR_DIGITS
+
+
+// Reads a run of digits and accumulates them into value. The value wraps around
+// if there are more than 19 digits, callers check the count and redo that rare case.
+static inline const char* eat_digits(const char* p, const char* end, uint64_t& value) {
+    uint64_t v = value;
+
+#ifdef SON_SWAR_DIGITS
+    while (end - p >= 8) {
+        uint64_t word = load_eight(p);
+        if (not is_eight_digits(word)) { break; }
+
+        v = v * 100000000 + parse_eight_digits(word);
+        p += 8;
+    }
+#endif
+
+    while (p < end && is_digit_byte(*p)) {
+        v = v * 10 + uint64_t(*p - '0');
+        p++;
+    }
+
+    value = v;
+    return p;
+}
+
+
+// Powers of ten that are exactly representable in double.
+static const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+
+// Clinger's fast path: when both the mantissa and the power of ten are exact doubles,
+// a single multiplication or division is correctly rounded.
+static bool fast_path(uint64_t mantissa, int32_t exponent, double& result) {
+    const uint64_t max_exact_mantissa = uint64_t(1) << 53;
+    if (mantissa > max_exact_mantissa) { return false; }
+
+    if (exponent < 0) {
+        if (exponent < -22) { return false; }
+        result = double(mantissa) / exact_powers_of_ten[-exponent];
+        return true;
+    }
+
+    // Move extra powers of ten into the mantissa while it stays exact, e.g. 123e25 = 123000e22.
+    while (exponent > 22) {
+        if (mantissa > max_exact_mantissa / 10) { return false; }
+        mantissa *= 10;
+        exponent -= 1;
+    }
+
+    result = double(mantissa) * exact_powers_of_ten[exponent];
+    return true;
+}
+
+
+// Everything that is not exact goes to the standard library. Since GCC 12 libstdc++
+// implements floating point from_chars with the Eisel-Lemire algorithm of fast_float.
+static bool slow_path(const char* begin, const char* end, double& result) {
+#ifdef __cpp_lib_to_chars
+    auto r = std::from_chars(begin, end, result);
+    return r.ec == std::errc();
+#else
+    std::string copy(begin, end);
+    char* copy_end = nullptr;
+    errno = 0;
+    result = strtod(copy.c_str(), &copy_end);
+    if (errno == ERANGE and (result == HUGE_VAL or result == 0.0)) { return false; } // Same as from_chars.
+    return copy_end == copy.c_str() + copy.size();
+#endif
+}
+
+
+// Power of ten of the first significant digit of digits with an optional point, e.g. 1 for "12.5",
+// 0 for "1.5" and -2 for "0.005". Digits must not be all zeros.
+static int64_t decimal_magnitude(const char* begin, const char* end) {
+    const char* point = (const char*)memchr(begin, '.', end - begin);
+    if (not point) { point = end; }
+
+    const char* first = begin;
+    while (first < end && (*first == '0' || *first == '.')) { first++; }
+
+    return first < point ? point - first : point - first + 1;
+}
+
+
+// Integer literal with more than 19 digits fits only if most of them are leading zeros.
+static bool long_integer(const char* begin, const char* end, uint64_t& value) {
+    while (begin < end && *begin == '0') { begin++; }
+    if (end - begin > 19) { return false; }
+
+    value = 0;
+    eat_digits(begin, end, value);
+    return true;
+}
+
+
+number_status scan_number(const char* p, const char* end, number& result) {
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    const char* unsigned_start = p;
+
+    uint64_t mantissa = 0;
+    const char* integral_end = eat_digits(p, end, mantissa);
+    p = integral_end;
+
+    bool is_floating = false;
+    int32_t fractional_count = 0;
+    if (p < end && *p == '.') {
+        is_floating = true;
+        const char* fractional_begin = p + 1;
+        p = eat_digits(fractional_begin, end, mantissa);
+        fractional_count = int32_t(p - fractional_begin);
+    }
+
+    int64_t digit_count = (integral_end - unsigned_start) + fractional_count;
+    if (digit_count == 0) {
+        result.end = start;
+        return number_status::not_a_number;
+    }
+
+    // Exponent is taken only if it has digits, otherwise 'e' belongs to the next token.
+    const char* mantissa_end = p;
+    int32_t exponent = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negative_exponent = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            negative_exponent = (*q == '-');
+            q++;
+        }
+
+        if (q < end && is_digit_byte(*q)) {
+            is_floating = true;
+            while (q < end && is_digit_byte(*q)) {
+                // Exponents this big are infinity or zero anyway, stop growing.
+                if (exponent < 100000) { exponent = exponent * 10 + (*q - '0'); }
+                q++;
+            }
+            if (negative_exponent) { exponent = -exponent; }
+            p = q;
+        }
+    }
+
+    result.end = p;
+    result.is_floating = is_floating;
+
+    if (not is_floating) {
+        if (digit_count > 19 && not long_integer(unsigned_start, integral_end, mantissa)) {
+            return number_status::out_of_range;
+        }
+        const uint64_t limit = negative ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX);
+        if (mantissa > limit) { return number_status::out_of_range; }
+
+        result.integer = negative ? int64_t(0 - mantissa) : int64_t(mantissa);
+        return number_status::ok;
+    }
+
+    double value = 0.0;
+    if (digit_count <= 19 && fast_path(mantissa, exponent - fractional_count, value)) {
+        // Exact.
+    } else if (not slow_path(unsigned_start, p, value)) {
+        // from_chars reports both overflow and underflow as out of range. They are told apart by
+        // the magnitude of the literal, the exponent alone is not enough: 1000...0.0 has none.
+        // Tiny numbers become zero.
+        if (decimal_magnitude(unsigned_start, mantissa_end) + exponent > 0) { return number_status::out_of_range; }
+        value = 0.0;
+    }
+
+    result.floating = negative ? -value : value;
+    return number_status::ok;
+}
+
+
+} // jslavic
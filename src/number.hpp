@@ -0,0 +1,37 @@
+#ifndef SON_NUMBER_HPP
+#define SON_NUMBER_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+namespace jslavic {
+
+
+// Number literal: [+-] digits [. digits] [(e|E) [+-] digits].
+// Digits may be omitted on one side of the point, but not on both.
+// Literals with a point or an exponent are floating, others are integers.
+
+
+enum class number_status {
+    ok,
+    not_a_number, // There are no digits where they are expected.
+    out_of_range, // Integer does not fit in int64_t, or floating is too big for double.
+};
+
+
+struct number {
+    bool is_floating = false;
+    int64_t integer = 0;
+    double floating = 0.0;
+    const char* end = nullptr; // One past the last character of the literal.
+};
+
+
+number_status scan_number(const char* p, const char* end, number& result);
+
+
+} // jslavic
+
+
+#endif // SON_NUMBER_HPP
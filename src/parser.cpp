@@ -1,971 +1,1110 @@
 #include <parser.hpp>
-#include <deque>
-#include <unordered_map>
-#include <fstream>
-#include <sstream>
-#include <inttypes.h>
+#include <document.hpp>
+#include "lexer.hpp"
+#include "structure.hpp"
+#include "threads.hpp"
+#include "input.hpp"
+#include "escape.hpp"
+#include "hash.hpp"
+#include <algorithm>
 
 
 namespace jslavic {
 
 
-enum kind_t {
-    TOKEN_UNDEFINED = 0,
+// Object or array that is being filled, and the key it will have in its parent.
+struct dom_frame {
+    son value;
+    std::string key;
+};
 
-    TOKEN_EQUAL_SIGN = '=',
-    TOKEN_SEMICOLON = ';',
-    TOKEN_COMMA = ',',
 
-    TOKEN_BRACE_OPEN = '{',
-    TOKEN_BRACE_CLOSE = '}',
+// Object or array that is being built in the arena of a document. Its pairs or elements
+// are staged from `start` on, and the key is the one it will have in its parent.
+struct staged_frame {
+    size_t start = 0;
+    std::string_view key;
+};
 
-    TOKEN_PAREN_OPEN = '(',
-    TOKEN_PAREN_CLOSE = ')',
 
-    TOKEN_BRACKET_OPEN = '[',
-    TOKEN_BRACKET_CLOSE = ']',
+// Buffers that outlive a single parse call. Containers of the previous
+// result are cleared and handed out again, so their capacity is reused.
+struct parser::scratch_t {
+    std::string buffer;
+    std::vector<son> spare_objects;
+    std::vector<son> spare_arrays;
+    std::vector<dom_frame> frames;
+
+    // Values and keys of containers that are not finished yet, when parsing into a document.
+    std::vector<son> staged_values;
+    std::vector<std::string_view> staged_keys;
+    std::vector<staged_frame> staged_frames;
+
+    // Keys are interned if settings ask for it. Keys that this parser has interned already are found
+    // in a flat hash table of its own, without locking the symbol table of the process.
+    bool intern_keys = false;
+    std::vector<son::key_t> interned; // Open addressing, free slots have id 0.
+    size_t interned_count = 0;
+
+    son::key_t intern(std::string_view key) {
+        if (interned.empty()) {
+            interned.resize(256);
+        }
 
-    TOKEN_KW_NULL = 256,
-    TOKEN_KW_TRUE,
-    TOKEN_KW_FALSE,
+        size_t mask = interned.size() - 1;
+        size_t i = hash_key(key) & mask;
+        while (interned[i].id() != 0) {
+            if (interned[i] == key) return interned[i];
+            i = (i + 1) & mask;
+        }
 
-    TOKEN_IDENTIFIER,
-    TOKEN_INTEGER,
-    TOKEN_FLOATING,
-    TOKEN_STRING,
+        son::key_t result = jslavic::intern(key);
+        if (result.id() == 0) {
+            return result; // Symbol table is full.
+        }
 
-    TOKEN_DOUBLE_SLASH,
+        interned[i] = result;
+        interned_count += 1;
 
-    TOKEN_EOF,
-};
+        // Kept at most half full, so probes stay short.
+        if (interned_count * 2 > interned.size()) {
+            std::vector<son::key_t> old(interned.size() * 2);
+            old.swap(interned);
+            mask = interned.size() - 1;
 
+            for (son::key_t& k : old) {
+                if (k.id() == 0) continue;
+                size_t j = hash_key(k.view()) & mask;
+                while (interned[j].id() != 0) { j = (j + 1) & mask; }
+                interned[j] = k;
+            }
+        }
 
-// static const char* to_debug_string(kind_t k) {
-//     switch (k) {
-//         case TOKEN_UNDEFINED:     return "TOKEN_UNDEFINED";
+        return result;
+    }
 
-//         case TOKEN_EQUAL_SIGN:    return "TOKEN_EQUAL_SIGN";
-//         case TOKEN_SEMICOLON:     return "TOKEN_SEMICOLON";
-//         case TOKEN_COMMA:         return "TOKEN_COMMA";
+    son take(son::type_t type) {
+        auto& spares = (type == son::type_t::object) ? spare_objects : spare_arrays;
+        if (spares.empty()) {
+            return son(type);
+        }
 
-//         case TOKEN_BRACE_OPEN:    return "TOKEN_BRACE_OPEN";
-//         case TOKEN_BRACE_CLOSE:   return "TOKEN_BRACE_CLOSE";
+        son result = std::move(spares.back());
+        spares.pop_back();
+        return result;
+    }
 
-//         case TOKEN_PAREN_OPEN:    return "TOKEN_PAREN_OPEN";
-//         case TOKEN_PAREN_CLOSE:   return "TOKEN_PAREN_CLOSE";
+    // Objects and arrays that are not taken apart yet, while the old tree is recycled.
+    std::vector<son> unvisited;
 
-//         case TOKEN_BRACKET_OPEN:  return "TOKEN_BRACKET_OPEN";
-//         case TOKEN_BRACKET_CLOSE: return "TOKEN_BRACKET_CLOSE";
+    // Takes the tree apart without recursion, so any depth of it is fine.
+    void recycle(son& value, size_t limit) {
+        unvisited.push_back(std::move(value));
+        value = son();
 
-//         case TOKEN_KW_NULL:       return "TOKEN_KW_NULL";
-//         case TOKEN_KW_TRUE:       return "TOKEN_KW_TRUE";
-//         case TOKEN_KW_FALSE:      return "TOKEN_KW_FALSE";
+        while (not unvisited.empty()) {
+            son current = std::move(unvisited.back());
+            unvisited.pop_back();
 
-//         case TOKEN_IDENTIFIER:    return "TOKEN_IDENTIFIER";
-//         case TOKEN_INTEGER:       return "TOKEN_INTEGER";
-//         case TOKEN_FLOATING:      return "TOKEN_FLOATING";
-//         case TOKEN_STRING:        return "TOKEN_STRING";
+            if (not current.is_object() and not current.is_array()) {
+                continue;
+            }
 
-//         case TOKEN_DOUBLE_SLASH:  return "TOKEN_DOUBLE_SLASH";
+            for (auto& child : current) {
+                if (child.is_object() or child.is_array()) {
+                    unvisited.push_back(std::move(child));
+                }
+            }
+            current.clear();
 
-//         case TOKEN_EOF:           return "TOKEN_EOF";
-//     }
+            auto& spares = current.is_object() ? spare_objects : spare_arrays;
+            if (spares.size() < limit) {
+                spares.push_back(std::move(current));
+            }
+        }
+    }
+};
 
-//     return "ERROR";
-// }
 
+// Parser pulls tokens from the lexer on demand and keeps only the current one.
+// Every decision is made by looking at that token, so nothing is ever parsed twice.
+// What was parsed is reported to the Handler as events, see sax_handler.
+//
+// Objects and arrays that are open are kept on an explicit stack instead of the call stack,
+// so deeply nested input is stopped by max_depth and cannot overflow the stack.
+template <typename Handler>
+struct parser_impl {
+    struct open_t {
+        kind_t closing;
+        bool is_object;
+    };
 
-// static const char* to_string(kind_t k) {
-//     switch (k) {
-//         case TOKEN_UNDEFINED:     return "? undefined";
+    lexer* lex = nullptr;
+    Handler* handler = nullptr;
+    token current;
 
-//         case TOKEN_EQUAL_SIGN:    return "=";
-//         case TOKEN_SEMICOLON:     return ";";
-//         case TOKEN_COMMA:         return ",";
+    std::vector<open_t> stack;
+    std::string unescaped; // Strings with escape sequences are decoded here.
+    size_t depth = 0; // Objects and arrays around the current value.
+    size_t node_count = 0; // Values parsed so far, objects and arrays included.
 
-//         case TOKEN_BRACE_OPEN:    return "{";
-//         case TOKEN_BRACE_CLOSE:   return "}";
+    size_t max_depth = SIZE_MAX;
+    size_t max_nodes = SIZE_MAX;
+    size_t max_string_length = SIZE_MAX;
 
-//         case TOKEN_PAREN_OPEN:    return "(";
-//         case TOKEN_PAREN_CLOSE:   return ")";
+    void set_limits(const parser::settings_t& settings) {
+        max_depth = settings.max_depth ? settings.max_depth : SIZE_MAX;
+        max_nodes = settings.max_nodes ? settings.max_nodes : SIZE_MAX;
+        max_string_length = settings.max_string_length ? settings.max_string_length : SIZE_MAX;
+    }
 
-//         case TOKEN_BRACKET_OPEN:  return "[";
-//         case TOKEN_BRACKET_CLOSE: return "]";
+    const token& peek() const { return current; }
+    void advance() { lex->next_token(current); }
 
-//         case TOKEN_KW_NULL:       return "null";
-//         case TOKEN_KW_TRUE:       return "true";
-//         case TOKEN_KW_FALSE:      return "false";
+    bool count_node() {
+        node_count += 1;
+        if (node_count > max_nodes) {
+            position_t where = lex->position(current.in_text.begin);
+            lex->report("%s:%lu:%lu: error: document has more values than max_nodes (%lu)\n",
+                lex->filename, where.line, where.column, max_nodes);
+            return false;
+        }
+        return true;
+    }
 
-//         case TOKEN_IDENTIFIER:    return "identifier";
-//         case TOKEN_INTEGER:       return "integer";
-//         case TOKEN_FLOATING:      return "floating";
-//         case TOKEN_STRING:        return "string";
+    bool parse_scalar() {
+        token t = peek();
 
-//         case TOKEN_DOUBLE_SLASH:  return "//";
+        switch (t.kind) {
+            case TOKEN_KW_NULL: {
+                if (not count_node() or not handler->on_null()) return false;
+                advance();
+                return true;
+            }
+            case TOKEN_KW_TRUE: {
+                if (not count_node() or not handler->on_boolean(true)) return false;
+                advance();
+                return true;
+            }
+            case TOKEN_KW_FALSE: {
+                if (not count_node() or not handler->on_boolean(false)) return false;
+                advance();
+                return true;
+            }
+            case TOKEN_INTEGER: {
+                if (not count_node() or not handler->on_integer(t.value.integer)) return false;
+                advance();
+                return true;
+            }
+            case TOKEN_FLOATING: {
+                if (not count_node() or not handler->on_floating(t.value.floating)) return false;
+                advance();
+                return true;
+            }
+            case TOKEN_STRING: {
+                if (t.in_text.size - 2 > max_string_length) {
+                    position_t where = lex->position(t.in_text.begin);
+                    lex->report("%s:%lu:%lu: error: string is longer than max_string_length (%lu)\n",
+                        lex->filename, where.line, where.column, max_string_length);
+                    return false;
+                }
+                if (not count_node() or not handler->on_string(decode_string(t, unescaped))) return false;
+                advance();
+                return true;
+            }
+            default:
+                lex->report_unexpected("value", t);
+                return false;
+        }
+    }
 
-//         case TOKEN_EOF:           return "EOF";
-//     }
+    bool parse_key() {
+        token t = peek();
 
-//     return "ERROR";
-// }
+        if (t.kind != TOKEN_IDENTIFIER) {
+            lex->report_unexpected("identifier", t);
+            return false;
+        }
+        if (t.in_text.size > max_string_length) {
+            position_t where = lex->position(t.in_text.begin);
+            lex->report("%s:%lu:%lu: error: key is longer than max_string_length (%lu)\n",
+                lex->filename, where.line, where.column, max_string_length);
+            return false;
+        }
+        advance();
 
+        if (peek().kind != TOKEN_EQUAL_SIGN) {
+            lex->report_unexpected("’=’", peek());
+            return false;
+        }
 
-struct span {
-    const char* begin = nullptr;
-    size_t size = 0;
+        if (not handler->on_key(std::string_view(t.in_text.begin, t.in_text.size))) return false;
+        advance();
+        return true;
+    }
 
-    span() : begin(nullptr), size(0) {}
-    span(const char* begin, size_t size) : begin(begin), size(size) {}
+    bool begin_container(bool is_object) {
+        if (depth >= max_depth) {
+            position_t where = lex->position(current.in_text.begin);
+            lex->report("%s:%lu:%lu: error: objects and arrays are nested deeper than max_depth (%lu)\n",
+                lex->filename, where.line, where.column, max_depth);
+            return false;
+        }
+        if (not count_node()) return false;
 
-    operator bool () { return size > 0; }
-};
+        if (not (is_object ? handler->on_object_begin() : handler->on_array_begin())) return false;
+        advance(); // Consume '{' or '['
+        depth += 1;
+        return true;
+    }
 
+    bool end_container(bool is_object) {
+        if (not (is_object ? handler->on_object_end() : handler->on_array_end())) return false;
+        advance(); // Consume '}' or ']'
+        depth -= 1;
+        return true;
+    }
 
-struct token {
-    union value_t {
-        int64_t integer;
-        double floating;
-    };
+    // Semicolon after a pair and comma after an element are optional.
+    void skip_separator(bool is_object) {
+        if (peek().kind == (is_object ? TOKEN_SEMICOLON : TOKEN_COMMA)) {
+            advance();
+        }
+    }
 
-    value_t value;
-    kind_t kind;
+    // Pairs or elements until the closing token, which is left for the caller.
+    // Objects and arrays inside are parsed by the same loop.
+    bool parse_until(kind_t closing, bool is_object) {
+        size_t bottom = stack.size() + 1;
+        stack.push_back({ closing, is_object });
 
-    // meta information
-    size_t line_number;
-    size_t char_number;
-    span in_text;
-    span line;
-};
+        while (true) {
+            open_t top = stack.back();
 
+            if (peek().kind == top.closing) {
+                if (stack.size() == bottom) break;
 
-// void print_token(token t) {
-//     printf("%3" PRIu64 ":%2" PRIu64 " token { kind = %20s; value = ", t.line_number, t.char_number, to_debug_string(t.kind));
-
-//     switch (t.kind) {
-//         case TOKEN_UNDEFINED: printf("ERROR! }\n"); break;
-//         case TOKEN_EOF:       printf("EOF; }\n"); break;
-//         case TOKEN_KW_NULL:   printf("null; }\n"); break;
-//         case TOKEN_KW_TRUE:   printf("true; }\n"); break;
-//         case TOKEN_KW_FALSE:  printf("false; }\n"); break;
-//         case TOKEN_INTEGER:   printf(PRId64"; }\n", t.value.integer); break;
-//         case TOKEN_FLOATING:  printf("%lf; }\n", t.value.floating); break;
-
-//         case TOKEN_IDENTIFIER:
-//         case TOKEN_STRING:
-//             printf("%.*s; }\n", int(t.in_text.size), t.in_text.begin);
-//             break;
-
-//         case TOKEN_EQUAL_SIGN:
-//         case TOKEN_SEMICOLON:
-//         case TOKEN_COMMA:
-//         case TOKEN_BRACE_OPEN:
-//         case TOKEN_BRACE_CLOSE:
-//         case TOKEN_PAREN_OPEN:
-//         case TOKEN_PAREN_CLOSE:
-//         case TOKEN_BRACKET_OPEN:
-//         case TOKEN_BRACKET_CLOSE:
-//             printf("'%c'; }\n", char(t.kind));
-//             break;
-
-//         case TOKEN_DOUBLE_SLASH:
-//             printf("//; }\n");
-//             break;
-//         default:
-//             printf("??? }\n");
-//     }
-// }
-
-
-
-typedef bool(*predicate_t)(char);
-
-// predicates
-static inline bool is_alpha (char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
-static inline bool is_digit (char c ) { return c >= '0' && c <= '9'; }
-static inline bool is_newline (char c) { return c == '\n' || c == '\r'; }
-static inline bool is_space (char c) { return c == ' ' || c == '\t' || is_newline(c); }
-static inline bool is_valid_identifier_head (char c) { return is_alpha(c) || c == '_'; }
-static inline bool is_valid_identifier_body (char c) { return is_digit(c) || is_alpha(c) || c == '_'; }
-
-// static strings 50 characters each
-// static const char* spaces = "                                                                         ";
-// static const char* carets = "^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^";
-
-
-struct lexer {
-    const char* filename = nullptr;
-    span text;
-    std::deque<token> token_stream;
-    std::unordered_map<std::string, kind_t> keywords;
+                stack.pop_back();
+                if (not end_container(top.is_object)) return false;
+                skip_separator(stack.back().is_object);
+                continue;
+            }
 
-    struct state_t {
-        const char* current_line = nullptr;
-        const char* current_char = nullptr;
+            if (peek().kind == TOKEN_EOF) {
+                lex->report_unexpected(top.is_object ? "’}’" : "’]’", peek());
+                return false;
+            }
 
-        size_t char_counter = 1;
-        size_t line_counter = 1;
-    };
+            if (top.is_object and not parse_key()) {
+                return false;
+            }
 
-    state_t state;
+            kind_t kind = peek().kind;
+            if (kind == TOKEN_BRACE_OPEN or kind == TOKEN_BRACKET_OPEN) {
+                bool nested_object = (kind == TOKEN_BRACE_OPEN);
+                if (not begin_container(nested_object)) return false;
 
-public:
-    lexer() {
-        keywords.emplace("null", TOKEN_KW_NULL);
-        keywords.emplace("true", TOKEN_KW_TRUE);
-        keywords.emplace("false", TOKEN_KW_FALSE);
-    }
+                stack.push_back({ nested_object ? TOKEN_BRACE_CLOSE : TOKEN_BRACKET_CLOSE, nested_object });
+                continue;
+            }
 
-    state_t get_checkpoint() const { return state; }
-    void restore_checkpoint(state_t checkpoint) { state = checkpoint; }
+            if (not parse_scalar()) {
+                return false;
+            }
+            skip_separator(top.is_object);
+        }
+
+        stack.pop_back();
+        return true;
+    }
 
-    inline char get_char () {
-        assert(state.current_char);
+    bool parse_value() {
+        kind_t kind = peek().kind;
 
-        if (state.current_char == text.begin + text.size) return 0;
+        if (kind == TOKEN_BRACE_OPEN) {
+            return begin_container(true) and parse_until(TOKEN_BRACE_CLOSE, true) and end_container(true);
+        }
+        if (kind == TOKEN_BRACKET_OPEN) {
+            return begin_container(false) and parse_until(TOKEN_BRACKET_CLOSE, false) and end_container(false);
+        }
 
-        return *state.current_char;
+        return parse_scalar();
     }
 
-    inline char eat_char () {
-        char c = get_char();
+    // Top level is decided by its first token. Identifier starts an object without braces,
+    // it goes until the end of file. Otherwise it is a sequence of values until the end of file.
+    bool parse_document() {
+        token t = peek();
 
-        if (is_newline(c)) {
-            state.char_counter = 0;
-            state.line_counter++;
-            state.current_line = state.current_char + 1;
+        if (t.kind == TOKEN_EOF) {
+            return false;
         }
 
-        c = get_char();
-
-        state.char_counter++;
-        state.current_char++;
+        if (t.kind == TOKEN_IDENTIFIER) {
+            depth = 1; // Object without braces counts as an object for max_depth.
+            return count_node()
+                and handler->on_object_begin()
+                and parse_until(TOKEN_EOF, true)
+                and handler->on_object_end();
+        }
 
-        return c;
+        return parse_until(TOKEN_EOF, false);
     }
+};
 
-    span eat_while(predicate_t predicate) {
-        auto checkpoint = get_checkpoint();
-        size_t count = 0;
 
-        char c;
-        while (true) {
-            c = get_char();
+// Builds son out of parser events. Finished values are moved into their parents.
+// Top level sequence is one value if it is a single object or array, otherwise it becomes a list.
+struct dom_builder {
+    parser::scratch_t* scratch = nullptr;
+    std::vector<dom_frame>* frames = nullptr;
+    size_t open = 0; // Frames in use. Frames after them are kept for the buffers of their keys.
 
-            if (c == 0 || not predicate(c)) { break; }
+    std::string key; // Key of the next value in the current object.
+    son root;
+    size_t root_count = 0;
 
-            eat_char();
-            count += 1;
-        }
+    void add_root(son&& value) {
+        root_count += 1;
 
-        return span(checkpoint.current_char, count);
-    }
+        if (root_count == 1) {
+            root = std::move(value);
+            return;
+        }
 
-    span eat_until(predicate_t predicate) {
-        auto checkpoint = get_checkpoint();
-        size_t count = 0;
+        if (root_count == 2) {
+            son list = scratch->take(son::type_t::array);
+            list.push(std::move(root));
+            root = std::move(list);
+        }
 
-        char c;
-        while (true) {
-            c = get_char();
+        root.push(std::move(value));
+    }
 
-            if (c == 0 || predicate(c)) { break; }
+    bool add(son&& value) {
+        if (open == 0) {
+            add_root(std::move(value));
+            return true;
+        }
 
-            eat_char();
-            count += 1;
+        son& parent = (*frames)[open - 1].value;
+        if (parent.is_object() and scratch->intern_keys) {
+            parent.push(scratch->intern(key), std::move(value));
+        } else if (parent.is_object()) {
+            parent.push(key, std::move(value));
+        } else {
+            parent.push(std::move(value));
         }
 
-        return span(checkpoint.current_char, count);
+        return true;
     }
 
-    span eat_string(const char* str, size_t n) {
-        auto checkpoint = get_checkpoint();
-        size_t count = 0;
+    bool on_null() { return add(son()); }
+    bool on_boolean(bool v) { return add(son(v)); }
+    bool on_integer(int64_t v) { return add(son(v)); }
+    bool on_floating(double v) { return add(son(v)); }
+    bool on_string(std::string_view v) { return add(son(v, std::pmr::get_default_resource())); }
 
-        while (count < n) {
-            char c = get_char();
+    bool on_key(std::string_view k) {
+        key.assign(k.data(), k.size());
+        return true;
+    }
 
-            if ((c == 0) || (c != str[count])) {
-                restore_checkpoint(checkpoint);
-                return span();
-            }
+    bool on_object_begin() { return begin_container(son::type_t::object); }
+    bool on_array_begin() { return begin_container(son::type_t::array); }
+    bool on_object_end() { return end_container(); }
+    bool on_array_end() { return end_container(); }
 
-            eat_char();
-            count += 1;
+    // Key swaps buffers with the frame, both ways, so keys of nested containers keep their capacity.
+    bool begin_container(son::type_t type) {
+        if (open == frames->size()) {
+            frames->emplace_back();
         }
 
-        return span(checkpoint.current_char, count);
+        dom_frame& frame = (*frames)[open++];
+        frame.value = scratch->take(type);
+        frame.key.swap(key);
+        return true;
     }
 
-    span eat_string(const char* str) {
-        auto checkpoint = get_checkpoint();
-        size_t count = 0;
+    bool end_container() {
+        dom_frame& frame = (*frames)[--open];
+        key.swap(frame.key);
+        return add(std::move(frame.value));
+    }
 
-        while (str[count]) {
-            char c = get_char();
+    son finish() {
+        // Containers that are still open after an error are dropped.
+        for (size_t i = 0; i < open; i++) {
+            (*frames)[i].value = son();
+        }
+        open = 0;
 
-            if ((c == 0) || (c != str[count])) {
-                restore_checkpoint(checkpoint);
-                return span();
-            }
+        if (root_count == 1 and not root.is_object() and not root.is_array()) {
+            son list = scratch->take(son::type_t::array);
+            list.push(std::move(root));
+            return list;
+        }
 
-            eat_char();
-            count += 1;
-        }
-
-        return span(checkpoint.current_char, count);
-    }
-
-    bool tokenize() {
-        char c;
-        while (eat_while(is_space), (c = get_char()) != 0) {
-            if (c == '{' ||
-                c == '}' ||
-                c == '(' ||
-                c == ')' ||
-                c == '[' ||
-                c == ']' ||
-                c == '=' ||
-                c == ';' ||
-                c == ',')
-            {
-                token t;
-                t.in_text.begin = state.current_char;
-                t.in_text.size = 1;
-                t.line_number = state.line_counter;
-                t.char_number = state.char_counter;
-                t.kind = kind_t(c);
-                t.value.integer = 0;
-
-                eat_char();
-
-                token_stream.push_back(t);
-                continue;
-            }
-            else if (c == '/') {
-                span result = eat_string("//");
-                if (result) {
-                    eat_until(is_newline);
-                    eat_while(is_newline);
-                    continue;
-                }
-            }
-            else if (c == '\"') {
-                bool successful = eat_quoted_string();
-                if (not successful) return false;
-            }
-            else if (is_digit(c) || (c == '.') || (c == '+') || (c == '-')) { // Read number, integer or float is unknown.
-                bool successful = eat_number();
-                if (not successful) return false;
-            }
-            else if (is_valid_identifier_head(c)) {
-                bool successful = eat_keyword_or_identifier();
-                if (not successful) return false;
-            }
-            else {
-                auto checkpoint = get_checkpoint();
-                auto result = eat_until(is_space);
+        return std::move(root);
+    }
+};
 
-                printf("%s:%lu:%lu: error: unknown lexeme ’%.*s’\n", filename, checkpoint.line_counter, checkpoint.char_counter, (int)result.size, result.begin);
 
-                // auto line = get_line();
-                // printf("   %lu | %.*s\n", checkpoint.line_counter, (int)line.length, line.start);
-                // printf("   %.*s | %.*s%.*s\n",
-                //     (int)(digits_in_number(checkpoint.line_counter)), spaces,
-                //     (int)(checkpoint.current - line.start), spaces,
-                //     (int)result.length, carets);
+// Builds son in the arena of a document. Pairs and elements are staged in scratch until their
+// object or array ends, then it is allocated once with the final size, so the arena has no
+// abandoned buffers of growing vectors. Keys are views into the text until then.
+struct document_builder {
+    parser::scratch_t* scratch = nullptr;
+    std::pmr::memory_resource* resource = nullptr;
 
-                // printf("Parse Error! Unknown lexeme: %.*s\n", i32(result.length), result.start);
-                return false;
-            }
-        }
+    std::string_view key; // Key of the next value in the current object.
 
-        if (c == '\0') {
-            token t;
-            t.in_text.begin = state.current_char;
-            t.in_text.size = 1;
-            t.line_number = state.line_counter;
-            t.char_number = state.char_counter;
-            t.kind = TOKEN_EOF;
-            t.value.integer = 0;
+    bool add(son&& value) {
+        scratch->staged_values.push_back(std::move(value));
+        scratch->staged_keys.push_back(key);
+        return true;
+    }
 
-            token_stream.push_back(t);
-            return true;
-        }
+    bool on_null() { return add(son()); }
+    bool on_boolean(bool v) { return add(son(v)); }
+    bool on_integer(int64_t v) { return add(son(v)); }
+    bool on_floating(double v) { return add(son(v)); }
+    bool on_string(std::string_view v) { return add(son(v, resource)); }
 
-        return false;
+    bool on_key(std::string_view k) {
+        key = k;
+        return true;
     }
 
-    // @Fix escaped newlines should not show up in resulted string.
-    bool eat_quoted_string () {
-        auto checkpoint = get_checkpoint();
-        uint64_t length = 0;
+    bool begin_container() {
+        scratch->staged_frames.push_back({ scratch->staged_values.size(), key });
+        return true;
+    }
 
-        char c = get_char();
-        if (c != '"') {
-            // No characters are eated yet. Return as normal.
-            return false;
-        }
+    bool on_object_begin() { return begin_container(); }
+    bool on_array_begin() { return begin_container(); }
 
-        eat_char(); // Skip double quote.
-        length += 1;
+    bool on_object_end() { return end_container(son::type_t::object); }
+    bool on_array_end() { return end_container(son::type_t::array); }
 
-        while ((c = get_char()) != '"') {
-            // Check for escape sequence.
-            if (c == '\\') {
-                // Skip two symbols, backslash and following escaped symbol.
-                eat_char();
-                eat_char();
-                length += 2;
-                continue;
+    // Moves staged values from `start` on into a new container.
+    son collect(son::type_t type, size_t start) {
+        auto& values = scratch->staged_values;
+        auto& keys = scratch->staged_keys;
+
+        son result(type, resource);
+        result.reserve(values.size() - start);
+
+        for (size_t i = start; i < values.size(); i++) {
+            if (type == son::type_t::object and scratch->intern_keys) {
+                result.push(scratch->intern(keys[i]), std::move(values[i]));
+            } else if (type == son::type_t::object) {
+                result.push(keys[i], std::move(values[i]));
+            } else {
+                result.push(std::move(values[i]));
             }
+        }
+
+        values.resize(start);
+        keys.resize(start);
+        return result;
+    }
 
-            // Newlines are not allowed to intercept string.
-            if (c == '\0' || is_newline(c)) {
-                restore_checkpoint(checkpoint);
+    bool end_container(son::type_t type) {
+        staged_frame frame = scratch->staged_frames.back();
+        scratch->staged_frames.pop_back();
 
-                // auto line = get_line();
+        son value = collect(type, frame.start);
+        key = frame.key;
+        return add(std::move(value));
+    }
 
-                // printf("%s:%lu:%lu: error: unclosed double quote\n", filename, checkpoint.line_counter, checkpoint.char_counter);
-                // printf("   %lu |%.*s\n", checkpoint.line_counter, (int)line.length, line.start);
-                // printf("   %.*s |%.*s%.*s\n",
-                //     (int)(digits_in_number(checkpoint.line_counter)), spaces,
-                //     (int)(checkpoint.current - line.start), spaces,
-                //     (int)(line.length - (checkpoint.current - line.start)), carets);
-                return false;
-            }
+    // Same shape as dom_builder gives. Staging is emptied even if parsing failed, its values are in the arena.
+    son finish() {
+        auto& values = scratch->staged_values;
+        son result;
 
-            // If it is not an escape symbol, just skip it once.
-            eat_char();
-            length += 1;
+        if (scratch->staged_frames.empty() and values.size() == 1 and (values[0].is_object() or values[0].is_array())) {
+            result = std::move(values[0]);
+        } else if (scratch->staged_frames.empty() and not values.empty()) {
+            result = collect(son::type_t::array, 0);
         }
 
-        eat_char(); // Skip double quote.
-        length += 1;
+        values.clear();
+        scratch->staged_keys.clear();
+        scratch->staged_frames.clear();
+        return result;
+    }
+};
 
-        token t;
-        t.in_text.begin = checkpoint.current_char;
-        t.in_text.size = length;
-        t.line_number = checkpoint.line_counter;
-        t.char_number = checkpoint.char_counter;
-        t.kind = TOKEN_STRING;
-        t.value.integer = 0;
 
-        token_stream.push_back(t);
-        return true;
+static bool exceeds_max_bytes(span text, const parser::settings_t& settings) {
+    return settings.max_bytes != 0 and text.size > settings.max_bytes;
+}
+
+
+template <typename Handler>
+static bool parse_events(span text, const char* filename, const parser::settings_t& settings, Handler& handler, std::string* errors = nullptr) {
+    lexer lex;
+    lex.filename = filename;
+    lex.text = text;
+    lex.errors = errors;
+    lex.validate_utf8 = settings.validate_utf8;
+
+    if (exceeds_max_bytes(text, settings)) {
+        lex.report("%s: error: text is longer than max_bytes (%lu)\n", filename, settings.max_bytes);
+        return false;
     }
 
-    bool eat_keyword_or_identifier () {
-        char c = get_char();
+    lex.state.current_char = lex.text.begin;
 
-        if (!is_valid_identifier_head(c)) {
-            return false;
-        }
+    parser_impl<Handler> parser;
+    parser.lex = &lex;
+    parser.handler = &handler;
+    parser.set_limits(settings);
+    parser.advance();
 
-        // This have to eat at least one symbol.
-        auto result = eat_while(is_valid_identifier_body);
+    return parser.parse_document();
+}
 
-        auto token_kind = keywords.find(std::string(result.begin, result.size));
-        if (token_kind == keywords.end()) {
-            // This is an identifier
 
-            token t;
-            t.in_text.begin = result.begin;
-            t.in_text.size = result.size;
-            t.line_number = state.line_counter;
-            t.char_number = state.char_counter;
-            t.kind = TOKEN_IDENTIFIER;
-            t.value.integer = 0;
+// Parses one part of the top level object or array into an object or array of its own.
+// Part that starts right after a value may start with its optional separator.
+static bool parse_part(span text, const char* file_begin, bool is_object, bool is_first, const parser::settings_t& settings, son& result, size_t& node_count) {
+    parser::scratch_t scratch;
+    scratch.intern_keys = settings.intern_keys;
 
-            token_stream.push_back(t);
-            return true;
-        }
+    lexer lex;
+    lex.filename = "<part>";
+    lex.text = text;
+    lex.file_begin = file_begin;
+    lex.quiet = true;
+    lex.validate_utf8 = settings.validate_utf8;
+    lex.state.current_char = lex.text.begin;
 
-        token t;
-        t.in_text = result;
-        t.line_number = state.line_counter;
-        t.char_number = state.char_counter;
-        t.kind = token_kind->second;
-        t.value.integer = 0;
+    dom_builder builder;
+    builder.scratch = &scratch;
+    builder.frames = &scratch.frames;
 
-        token_stream.push_back(t);
-        return true;
+    parser_impl<dom_builder> parser;
+    parser.lex = &lex;
+    parser.handler = &builder;
+    parser.set_limits(settings);
+    parser.depth = 1; // Inside of the top level object or array.
+    parser.advance();
+
+    if (not is_first and parser.peek().kind == (is_object ? TOKEN_SEMICOLON : TOKEN_COMMA)) {
+        parser.advance();
     }
 
-    bool eat_number () {
-        const char* start = state.current_char;
-        uint64_t len = 0;
+    bool successful = is_object
+        ? builder.on_object_begin() and parser.parse_until(TOKEN_EOF, true) and builder.on_object_end()
+        : builder.on_array_begin() and parser.parse_until(TOKEN_EOF, false) and builder.on_array_end();
 
-        char c = get_char();
-        if (!is_digit(c) && c != '.' && c != '-' && c != '+') {
-            return false;
-        }
+    result = builder.finish();
+    node_count = parser.node_count;
+    return successful;
+}
 
-        int64_t sign = 1;
-        int64_t integral = 0;
-        double fractional = 0.;
-        double multiplier = 1.;
 
-        if (c == '-' || c == '+') {
-            sign = (c == '-' ? -1 : 1);
-            eat_char();
-            len += 1;
-        }
+// Splits the top level into parts, parses them on several threads and stitches the results in order.
+// Returns false when the text cannot be split or a part fails, then it is parsed again on one thread.
+// Every part is held to the limits on its own; the sum of values is checked after all are parsed.
+static bool parse_parallel(span text, const parser::settings_t& settings, son& target) {
+    size_t threads = thread_count(settings.threads);
+    if (threads < 2 or text.size < settings.parallel_threshold or exceeds_max_bytes(text, settings)) {
+        return false;
+    }
 
-        while (is_digit(c = get_char())) {
-            eat_char();
-            len += 1;
+    top_level_parts split;
+    if (not split_top_level(text, threads, split) or split.parts.size() < 2) {
+        return false;
+    }
 
-            integral *= 10;
-            integral += (c - '0');
-        }
+    size_t count = split.parts.size();
+    std::vector<son> results(count);
+    std::vector<char> successes(count, 0);
+    std::vector<size_t> node_counts(count, 0);
+
+    run_parallel(count, threads, [&](size_t i, size_t) {
+        successes[i] = parse_part(split.parts[i], text.begin, split.is_object, i == 0, settings, results[i], node_counts[i]);
+    });
 
-        if (c == '.') {
-            eat_char();
-            len += 1;
+    size_t node_count = 1; // The top level object or array.
+    for (size_t i = 0; i < count; i++) {
+        if (not successes[i]) return false;
+        node_count += node_counts[i];
+    }
 
-            while(is_digit(c = get_char())) {
-                eat_char();
-                len += 1;
+    if (settings.max_nodes != 0 and node_count > settings.max_nodes) {
+        return false;
+    }
 
-                multiplier *= 0.1;
-                fractional += (c - '0') * multiplier;
+    son result = std::move(results[0]);
+    for (size_t i = 1; i < count; i++) {
+        if (split.is_object) {
+            auto pairs = results[i].pairs();
+            for (auto it = pairs.begin(); it != pairs.end(); ++it) {
+                result.push(it.key(), std::move(it.value())); // Interned and short keys are not allocated again.
+            }
+        } else {
+            for (son& value : results[i]) {
+                result.push(std::move(value));
             }
+        }
+    }
 
-            token t;
-            t.in_text.begin = start;
-            t.in_text.size = len;
-            t.line_number = state.line_counter;
-            t.char_number = state.char_counter;
-            t.kind = TOKEN_FLOATING;
-            t.value.floating = sign*(integral + fractional);
+    target = std::move(result);
+    return true;
+}
 
-            token_stream.push_back(t);
-            return true;
-        }
 
-        token t;
-        t.in_text.begin = start;
-        t.in_text.size = len;
-        t.line_number = state.line_counter;
-        t.char_number = state.char_counter;
-        t.kind = TOKEN_INTEGER;
-        t.value.integer = sign*integral;
+static bool parse_text(span text, const char* filename, parser::scratch_t& scratch, const parser::settings_t& settings, son& target, std::string* errors = nullptr) {
+    scratch.recycle(target, settings.max_spare_containers);
+    scratch.intern_keys = settings.intern_keys;
 
-        token_stream.push_back(t);
+    if (parse_parallel(text, settings, target)) {
         return true;
     }
-};
 
+    dom_builder builder;
+    builder.scratch = &scratch;
+    builder.frames = &scratch.frames;
 
-std::string read_whole_file(const char *filename) {
-    std::ifstream input(filename, std::ios::in | std::ios::binary);
-    std::ostringstream content;
+    bool successful = parse_events(text, filename, settings, builder, errors);
 
-    if (input.good()) {
-        content << input.rdbuf();
+    son result = builder.finish();
+    if (successful) {
+        target = std::move(result);
     }
 
-    return content.str();
+    return successful;
 }
 
 
-struct parser_impl {
-    std::deque<token> token_stream;
-    std::deque<token>::iterator it;
+// Parsed into the arena of the document. Parts are not parsed in parallel: the arena is not thread-safe.
+static bool parse_text(span text, const char* filename, parser::scratch_t& scratch, const parser::settings_t& settings, document& target) {
+    target.clear();
+    scratch.intern_keys = settings.intern_keys;
 
-    son parse_array(bool top_level = false) {
-        auto checkpoint = it;
+    document_builder builder;
+    builder.scratch = &scratch;
+    builder.resource = target.resource();
 
-        son result(son::type_t::array);
-        bool have_open_bracket = false;
+    bool successful = parse_events(text, filename, settings, builder);
 
-        {
-            token t = *it;
+    son result = builder.finish();
+    if (successful) {
+        target.value() = std::move(result);
+    }
 
-            if (t.kind != TOKEN_BRACKET_OPEN and !top_level) {
-                // report error
-                // "%s:%lu:%lu: error: ’[’ is expected, found %s ’%.*s’\n"
+    return successful;
+}
 
-                it = checkpoint;
-                return son();
-            }
 
-            have_open_bracket = t.kind == TOKEN_BRACKET_OPEN;
-            if (have_open_bracket) {
-                // t_bracket_open = t;
-                it++;
-            }
-        }
+// One step of a path: a key in an object, or an index in an array.
+struct path_segment {
+    std::string key;
+    size_t index = 0;
+    bool is_index = false;
+};
 
-middle:
-        do {
-            {
-                token t = *it;
-
-                switch (t.kind) {
-                    case TOKEN_KW_NULL: {
-                        result.push(son());
-                        it++;
-                        break;
-                    }
-                    case TOKEN_KW_TRUE: {
-                        result.push(true);
-                        it++;
-                        break;
-                    }
-                    case TOKEN_KW_FALSE: {
-                        result.push(false);
-                        it++;
-                        break;
-                    }
-                    case TOKEN_INTEGER: {
-                        result.push(t.value.integer);
-                        it++;
-                        break;
-                    }
-                    case TOKEN_FLOATING: {
-                        result.push(t.value.floating);
-                        it++;
-                        break;
-                    }
-                    case TOKEN_STRING: {
-                        result.push(std::string(t.in_text.begin + 1, t.in_text.size - 2));
-                        it++;
-                        break;
-                    }
-                    case TOKEN_BRACE_OPEN: {
-                        // This is an object
-                        son object = parse_object(false);
-
-                        if (object.is_null()) {
-                            it = checkpoint;
-                            return son();
-                        }
-
-                        result.push(object);
-                        break;
-                    }
-                    case TOKEN_BRACKET_OPEN: {
-                        // This is a nested array
-                        son array = parse_array(false);
-
-                        if (array.is_null()) {
-                            it = checkpoint;
-                            return son();
-                        }
-
-                        result.push(array);
-                        break;
-                    }
-                    case TOKEN_BRACKET_CLOSE: // If empty list
-                        break;
-                    default:
-                        // error_t error;
-                        // eprintf(error, "%s:%lu:%lu: error: ’]’ is expected, found %s ’%.*s’\n",
-
-                        it = checkpoint;
-                        return son();
-                }
-            }
 
-            {
-                token t = *it;
+// Splits "db.replicas[3].host" into segments. Returns false if the path is not valid.
+static bool split_path(const std::string& path, std::vector<path_segment>& segments) {
+    const char* p = path.c_str();
+    const char* end = p + path.size();
 
-                if (t.kind == TOKEN_COMMA) {
-                    it++;
-                }
+    while (p < end) {
+        path_segment segment;
 
-                if (t.kind == TOKEN_BRACKET_CLOSE or t.kind == TOKEN_EOF) {
-                    break;
-                }
+        if (*p == '[') {
+            p++;
+
+            const char* digits = p;
+            while (p < end and is_digit(*p)) {
+                segment.index = segment.index * 10 + size_t(*p - '0');
+                p++;
             }
-        } while (true);
 
-        {
-            token t = *it;
+            if (p == digits or p == end or *p != ']') return false;
+            p++;
+            segment.is_index = true;
+        } else {
+            if (not segments.empty() and *p == '.') p++;
 
-            if (have_open_bracket and t.kind == TOKEN_BRACKET_CLOSE) {
-                // Consume ']'
-                it++;
-            }
-            else if (!have_open_bracket and t.kind == TOKEN_BRACKET_CLOSE) {
-                // error_t error;
-                // eprintf(error, "%s:%lu:%lu: error: expected EOF (end of naked top level list), found %s ’%.*s’\n",
-                it = checkpoint;
-                return son();
-            }
-            else if (have_open_bracket and t.kind != TOKEN_BRACKET_CLOSE) {
-                // error_t error;
-                // eprintf(error, "%s:%lu:%lu: error: ’]’ is expected, found %s ’%.*s’\n",
-                it = checkpoint;
-                return son();
-            }
-        }
+            const char* key = p;
+            if (p == end or not is_valid_identifier_head(*p)) return false;
+            while (p < end and is_valid_identifier_body(*p)) { p++; }
 
-        {
-            token t = *it;
-            if (t.kind != TOKEN_EOF and top_level) {
-                son top_level_list;
-                top_level_list.push(result);
-                result = top_level_list;
-                have_open_bracket = false;
-                goto middle; // @FIX BAD BAD BAD!!!
-            }
+            segment.key.assign(key, p - key);
         }
 
-        return result;
+        segments.push_back(std::move(segment));
     }
 
-    bool parse_key_value_pair(std::string& key, son& value, bool top_level) {
-        auto checkpoint = it;
+    return not segments.empty();
+}
 
-        {
-            token t = *it;
 
-            if (top_level and t.kind == TOKEN_EOF) { return false; }
-            if (not top_level and t.kind == TOKEN_BRACE_CLOSE) { return false; }
-            if (t.kind != TOKEN_IDENTIFIER) {
-                // report error
-                // "%s:%lu:%lu: error: expected identifier, but found %s ’%.*s’\n"
+// Walks the text by its structure only, and parses values that paths lead to.
+// Everything else is skipped with skip_value: it is not lexed, and its numbers are not decoded.
+struct path_walker {
+    struct path_t {
+        std::vector<path_segment> segments;
+        son value;
+        bool found = false;
+    };
 
-                it = checkpoint;
-                return false;
+    span text;
+    const char* end = nullptr;
+    parser::scratch_t* scratch = nullptr;
+    const parser::settings_t* settings = nullptr;
+    std::vector<path_t> paths;
+    bool top_is_list = false; // Top level is a sequence of values, its list is not an object or array in the text.
+
+    // Parses one value and returns where the text after it starts, or nullptr on error. Value at
+    // `depth` is inside of that many objects and arrays, or one less if the top level is a list.
+    const char* parse_value(const char* begin, size_t depth, son& result) {
+        lexer lex;
+        lex.filename = "<path>";
+        lex.text = span(begin, end - begin);
+        lex.file_begin = text.begin;
+        lex.quiet = true;
+        lex.validate_utf8 = settings->validate_utf8;
+        lex.state.current_char = lex.text.begin;
+    
+        dom_builder builder;
+        builder.scratch = scratch;
+        builder.frames = &scratch->frames;
+
+        parser_impl<dom_builder> parser;
+        parser.lex = &lex;
+        parser.handler = &builder;
+        parser.set_limits(*settings);
+        parser.depth = (top_is_list and depth > 0) ? depth - 1 : depth;
+        parser.advance();
+
+        bool successful = parser.parse_value() and parser.peek().kind != TOKEN_UNDEFINED;
+        result = std::move(builder.root);
+        scratch->frames.clear();
+        return successful ? parser.peek().in_text.begin : nullptr;
+    }
+
+    // Follows the rest of a path inside of a value that is already parsed.
+    static son* find(son& value, const std::vector<path_segment>& segments, size_t depth) {
+        son* current = &value;
+
+        for (size_t i = depth; i < segments.size(); i++) {
+            const path_segment& segment = segments[i];
+            son* next = nullptr;
+
+            if (segment.is_index and current->is_array() and segment.index < current->size()) {
+                next = &(*current)[int32_t(segment.index)];
+            } else if (not segment.is_index and current->is_object()) {
+                next = current->find(segment.key);
             }
 
-            key = std::string(t.in_text.begin, t.in_text.size);
-            it++;
+            if (not next) return nullptr;
+            current = next;
         }
 
-        {
-            token t = *it;
-
-            if (t.kind != TOKEN_EQUAL_SIGN) {
-                // report error
-                // "%s:%lu:%lu: error: expected ’=’, but found %s ’%.*s’\n"
+        return current;
+    }
 
-                it = checkpoint;
-                return false;
+    // Value at p is reached by the first `depth` segments of the active paths. Text of the value
+    // is gone through once: it is either parsed, walked into or skipped.
+    const char* walk_value(const char* p, const std::vector<size_t>& active, size_t depth) {
+        // A path ends here: parse the whole value, and find longer paths inside of it.
+        for (size_t i : active) {
+            if (paths[i].segments.size() != depth) continue;
+
+            son value;
+            const char* value_end = parse_value(p, depth, value);
+            if (not value_end) return nullptr;
+
+            for (size_t j : active) {
+                son* found = find(value, paths[j].segments, depth);
+                if (found and not paths[j].found) {
+                    paths[j].value = *found;
+                    paths[j].found = true;
+                }
             }
 
-            it++;
+            return value_end;
         }
 
-        {
-            token t = *it;
+        if (*p == '{') return walk_container(p + 1, '}', true, active, depth);
+        if (*p == '[') return walk_container(p + 1, ']', false, active, depth);
 
-            switch (t.kind) {
-            case TOKEN_KW_NULL: {
-                value = son();
-                it++;
-                break;
-            }
-            case TOKEN_KW_TRUE: {
-                value = son(true);
-                it++;
-                break;
-            }
-            case TOKEN_KW_FALSE: {
-                value = son(false);
-                it++;
-                break;
-            }
-            case TOKEN_INTEGER: {
-                value = son(t.value.integer);
-                it++;
-                break;
-            }
-            case TOKEN_FLOATING: {
-                value = son(t.value.floating);
-                it++;
-                break;
-            }
-            case TOKEN_STRING: {
-                value = son(std::string(t.in_text.begin + 1, t.in_text.size - 2));
-                it++;
-                break;
-            }
-            case TOKEN_BRACE_OPEN: {
-                son object = parse_object(false);
-                if (object.is_null()) {
-                    // report error
-                    // "%s:%lu:%lu: error: value is expected, found %s ’%.*s’\n"
+        return skip_value(p, end);
+    }
 
-                    it = checkpoint;
-                    return false;
-                }
+    // Pairs or elements until the closing character, or until the end of text if it is 0.
+    const char* walk_container(const char* p, char closing, bool is_object, const std::vector<size_t>& active, size_t depth) {
+        char separator = is_object ? ';' : ',';
+        std::vector<size_t> matching;
+        std::vector<size_t> unmatched; // Paths of an object go into the first pair with their key, as lookups do.
+        if (is_object) unmatched = active;
 
-                value = std::move(object);
-                break;
-            }
-            case TOKEN_BRACKET_OPEN: {
-                son array = parse_array(false);
-                if (array.is_null()) {
-                    // report error
-                    // "%s:%lu:%lu: error: value is expected, found %s ’%.*s’\n"
+        for (size_t index = 0; ; index++) {
+            p = skip_blank(p, end);
 
-                    it = checkpoint;
-                    return false;
+            if (p == end) return (closing == 0) ? p : nullptr;
+            if (*p == closing) return p + 1;
+
+            matching.clear();
+
+            if (is_object) {
+                const char* key = p;
+                if (not is_valid_identifier_head(*p)) return nullptr;
+                while (p < end and is_valid_identifier_body(*p)) { p++; }
+
+                // Keywords are not keys; the document is parsed again to report it.
+                if (keyword_or_identifier(key, p - key) != TOKEN_IDENTIFIER) return nullptr;
+
+                std::string_view name(key, p - key);
+                for (size_t i : unmatched) {
+                    const path_segment& segment = paths[i].segments[depth];
+                    if (not segment.is_index and segment.key == name) matching.push_back(i);
+                }
+                if (not matching.empty()) {
+                    unmatched.erase(std::remove_if(unmatched.begin(), unmatched.end(),
+                        [&](size_t i) { return std::find(matching.begin(), matching.end(), i) != matching.end(); }), unmatched.end());
                 }
 
-                value = array;
-                break;
+                p = skip_blank(p, end);
+                if (p == end or *p != '=') return nullptr;
+                p = skip_blank(p + 1, end);
+            } else {
+                for (size_t i : active) {
+                    const path_segment& segment = paths[i].segments[depth];
+                    if (segment.is_index and segment.index == index) matching.push_back(i);
+                }
             }
-            default: {
-                // report error
-                // "%s:%lu:%lu: error: value is expected, found ’%.*s’\n"
 
-                it = checkpoint;
-                return false;
+            p = matching.empty() ? skip_value(p, end) : walk_value(p, matching, depth + 1);
+            if (not p) return nullptr;
+
+            p = skip_blank(p, end);
+            if (p < end and *p == separator) p++;
+        }
+    }
+
+    // Top level has the same shape as parse() gives: object without braces, single object or array,
+    // or a list of all top level values.
+    bool walk() {
+        const char* p = skip_blank(text.begin, end);
+        if (p == end) return false;
+
+        std::vector<size_t> active;
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (not paths[i].segments.empty()) active.push_back(i);
+        }
+
+        if (is_valid_identifier_head(*p)) {
+            const char* word_end = skip_value(p, end);
+            if (keyword_or_identifier(p, word_end - p) == TOKEN_IDENTIFIER) {
+                return walk_container(p, 0, true, active, 0) != nullptr;
             }
+        }
+
+        if (*p == '{' or *p == '[') {
+            const char* after = skip_container(p, end);
+            if (after and skip_blank(after, end) == end) {
+                return walk_value(p, active, 0) != nullptr;
             }
         }
 
-        {
-            token t = *it;
+        top_is_list = true;
+        return walk_container(p, 0, false, active, 0) != nullptr;
+    }
+};
 
-            if (t.kind == TOKEN_SEMICOLON) {
-                it++; // Skip semicolon.
-            } else {
-                // Semicolon is optional.
-            }
+
+static son parse_paths_text(span text, const char* filename, parser::scratch_t& scratch, const parser::settings_t& settings, const std::vector<std::string>& paths) {
+    path_walker walker;
+    walker.text = text;
+    walker.end = text.begin + text.size;
+    walker.scratch = &scratch;
+    walker.settings = &settings;
+    scratch.intern_keys = settings.intern_keys;
+    walker.paths.resize(paths.size());
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (not split_path(paths[i], walker.paths[i].segments)) {
+            walker.paths[i].segments.clear();
         }
+    }
 
-        // We reached the end, it's all good.
-        return true;
+    if (exceeds_max_bytes(text, settings) or not walker.walk()) {
+        // Parse everything to report errors the usual way.
+        son ignored;
+        parse_text(text, filename, scratch, settings, ignored);
+        return son();
     }
 
-    son parse_object(bool top_level = false) {
-        auto checkpoint = it;
-        bool have_open_brace = false;
+    son result(son::type_t::object);
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (walker.paths[i].found) {
+            result.push(paths[i], std::move(walker.paths[i].value));
+        }
+    }
 
-        son result;
+    return result;
+}
 
-        {
-            token t = *it;
-            if (!(t.kind == TOKEN_BRACE_OPEN or
-                 (t.kind == TOKEN_IDENTIFIER and top_level))) {
-                // "%s:%lu:%lu: error: '{' expected, found %s ’%.*s’\n"
 
-                it = checkpoint;
-                return son();
-            }
+parser::parser()
+    : scratch(new scratch_t())
+{}
 
-            have_open_brace = t.kind == TOKEN_BRACE_OPEN;
 
-            if (t.kind == TOKEN_BRACE_OPEN) {
-                it++;
-            }
-        }
+parser::parser(const char* filename)
+    : filename(filename)
+    , scratch(new scratch_t())
+{}
 
-        {
-            do {
-                token t = *it;
 
-                if (t.kind != TOKEN_IDENTIFIER) break;
+parser::parser(std::string filename)
+    : filename(std::move(filename))
+    , scratch(new scratch_t())
+{}
 
-                std::string key;
-                son value;
-                if (!parse_key_value_pair(key, value, top_level)) break;
 
-                result.push(key, value);
-            } while (true);
-        }
+parser::parser(std::string filename, settings_t settings)
+    : filename(std::move(filename))
+    , scratch(new scratch_t())
+    , settings(settings)
+{}
 
-        {
-            token t = *it;
 
-            if (top_level and have_open_brace and t.kind != TOKEN_BRACE_CLOSE) {
-                // report error
-                // "%s:%lu:%lu: error: '}' expected, found %s ’%.*s’\n"
+parser::~parser() = default;
+parser::parser(parser&&) noexcept = default;
+parser& parser::operator=(parser&&) noexcept = default;
 
-                it = checkpoint;
-                return son();
-            }
 
-            if (top_level and !have_open_brace and t.kind != TOKEN_EOF) {
-                // report error
-                // "%s:%lu:%lu: error: expected EOF (end of naked top level object), but found %s ’%.*s’\n"
+son parser::parse() {
+    son result;
+    parse_into(result);
+    return result;
+}
 
-                it = checkpoint;
-                return son();
-            }
 
-            if (top_level and have_open_brace and t.kind != TOKEN_BRACE_CLOSE) {
-                // report error
-                // "%s:%lu:%lu: error: '}' expected, found %s ’%.*s’\n"
+son parser::parse(std::string_view text) {
+    son result;
+    parse_into(text, result);
+    return result;
+}
 
-                it = checkpoint;
-                return son();
-            }
 
-            if (top_level and !have_open_brace and t.kind != TOKEN_EOF) {
-                // report error
-                // "%s:%lu:%lu: error: expected EOF (end of naked top level object), but found %s ’%.*s’\n"
+bool parser::parse_into(son& target) {
+    input_text input(scratch->buffer);
+    if (not input.open(filename.c_str(), settings.use_mmap, settings.max_bytes)) {
+        scratch->recycle(target, settings.max_spare_containers);
+        return false;
+    }
 
-                it = checkpoint;
-                return son();
-            }
+    return parse_text(input.text, filename.c_str(), *scratch, settings, target);
+}
 
-            if (!top_level and !have_open_brace) {
-                assert(false); // I don't know is this even possible
-            }
 
-            if (have_open_brace and t.kind != TOKEN_BRACE_CLOSE) {
-                // report error
-                // "%s:%lu:%lu: error: '}' expected, found %s ’%.*s’\n"
+bool parser::parse_into(std::string_view text, son& target) {
+    return parse_text(span(text.data(), text.size()), "<memory>", *scratch, settings, target);
+}
 
-                it = checkpoint;
-                return son();
-            }
 
-            if (t.kind == TOKEN_BRACE_CLOSE) {
-                it++; // Consume '}'
-            }
-        }
+bool parser::parse_into(document& target) {
+    input_text input(scratch->buffer);
+    if (not input.open(filename.c_str(), settings.use_mmap, settings.max_bytes)) {
+        target.clear();
+        return false;
+    }
 
-        return result;
+    return parse_text(input.text, filename.c_str(), *scratch, settings, target);
+}
+
+
+bool parser::parse_into(std::string_view text, document& target) {
+    return parse_text(span(text.data(), text.size()), "<memory>", *scratch, settings, target);
+}
+
+
+bool parser::parse(sax_handler& handler) {
+    input_text input(scratch->buffer);
+    if (not input.open(filename.c_str(), settings.use_mmap, settings.max_bytes)) {
+        return false;
     }
-};
 
+    return parse_events(input.text, filename.c_str(), settings, handler);
+}
 
-son parse_impl(lexer& lex) {
-    auto begin = lex.token_stream.begin();
-    auto end = lex.token_stream.end();
-    
-    parser_impl parser;
-    parser.token_stream = std::move(lex.token_stream);
-    parser.it = parser.token_stream.begin();
 
-    son obj = parser.parse_object(true);
+bool parser::parse(std::string_view text, sax_handler& handler) {
+    return parse_events(span(text.data(), text.size()), "<memory>", settings, handler);
+}
 
-    if (!obj.is_null()) {
-        return obj;
+son parser::parse_paths(const std::vector<std::string>& paths) {
+    input_text input(scratch->buffer);
+    if (not input.open(filename.c_str(), settings.use_mmap, settings.max_bytes)) {
+        return son();
     }
 
-    begin = lex.token_stream.begin();
-    end = lex.token_stream.end();
+    return parse_paths_text(input.text, filename.c_str(), *scratch, settings, paths);
+}
 
-    son arr = parser.parse_array(true);
 
-    return arr;
+son parser::parse_paths(std::string_view text, const std::vector<std::string>& paths) {
+    return parse_paths_text(span(text.data(), text.size()), "<memory>", *scratch, settings, paths);
 }
 
+template <typename Input>
+static std::vector<parse_result> parse_many_impl(size_t count, size_t threads, parser::settings_t settings, Input&& input) {
+    std::vector<parse_result> results(count);
 
-son parser::parse() {
-    lexer lex;
-    lex.filename = filename.c_str();
+    threads = thread_count(threads);
+    settings.threads = 1; // Files are already parsed in parallel.
 
-    std::string text = read_whole_file(filename.c_str());
-    lex.text.begin = text.data();
-    lex.text.size = text.size();
+    std::vector<parser::scratch_t> scratches(std::min(threads, std::max(count, size_t(1))));
 
-    lex.state.current_char = lex.text.begin;
-    lex.state.current_line = lex.text.begin;
+    run_parallel(count, threads, [&](size_t i, size_t worker) {
+        parse_result& result = results[i];
+        const char* name = input(i, scratches[worker], settings, result);
 
-    lex.tokenize();
+        if (not result.successful and result.errors.empty()) {
+            result.errors = std::string(name) + ": error: document is not valid\n";
+        }
+    });
 
-    return parse_impl(lex);
+    return results;
 }
 
-};
 
+std::vector<parse_result> parse_many(const std::vector<std::string>& filenames, size_t threads, parser::settings_t settings) {
+    return parse_many_impl(filenames.size(), threads, settings,
+        [&](size_t i, parser::scratch_t& scratch, const parser::settings_t& settings, parse_result& result) {
+            const char* filename = filenames[i].c_str();
+
+            input_text input(scratch.buffer);
+            if (not input.open(filename, settings.use_mmap, settings.max_bytes)) {
+                result.errors = filenames[i] + ": error: could not read the file\n";
+                return filename;
+            }
+
+            result.successful = parse_text(input.text, filename, scratch, settings, result.value, &result.errors);
+            return filename;
+        });
+}
+
+
+std::vector<parse_result> parse_many_texts(const std::vector<std::string_view>& texts, size_t threads, parser::settings_t settings) {
+    return parse_many_impl(texts.size(), threads, settings,
+        [&](size_t i, parser::scratch_t& scratch, const parser::settings_t& settings, parse_result& result) {
+            span text(texts[i].data(), texts[i].size());
+            result.successful = parse_text(text, "<memory>", scratch, settings, result.value, &result.errors);
+            return "<memory>";
+        });
+}
+
+};
@@ -0,0 +1,205 @@
+#include <records.hpp>
+#include <incremental.hpp>
+#include "input.hpp"
+#include "lexer.hpp"
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+
+namespace jslavic {
+
+
+struct record_reader::impl_t {
+    incremental_parser parser;
+
+    std::string chunk;
+    input_text input; // Mapped, or read into chunk one slice at a time.
+
+    size_t offset = 0;   // How much of the mapping was fed to the parser.
+    size_t released = 0; // How much of the mapping was given back to the system.
+
+    bool finished = false;
+    bool failed = false;
+
+    // Text is fed to the parser in slices this big.
+    static constexpr size_t slice_size = 64 * 1024;
+
+    // Pages that were read are given back in batches this big.
+    static constexpr size_t release_size = 16 * 1024 * 1024;
+
+    impl_t() : input(chunk) {}
+
+#ifdef SON_HAS_MMAP
+    void release_pages() {
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t upto = offset - offset % page_size;
+
+        if (upto - released >= release_size) {
+            madvise((void*)(input.text.begin + released), upto - released, MADV_DONTNEED);
+            released = upto;
+        }
+    }
+#endif
+
+    // Feeds the next slice of the file to the parser, and finishes it at the end of the file.
+    bool feed_more() {
+        size_t size = 0;
+        bool successful = true;
+
+        if (input.mapping) {
+            size = std::min(slice_size, input.text.size - offset);
+            successful = parser.feed_in_place(input.text.begin + offset, size);
+            offset += size;
+#ifdef SON_HAS_MMAP
+            release_pages();
+#endif
+        } else {
+            chunk.resize(slice_size);
+            long n = input.read_some(&chunk[0], chunk.size());
+            if (n < 0) {
+                failed = true;
+                return false;
+            }
+
+            size = static_cast<size_t>(n);
+            successful = parser.feed(chunk.data(), size);
+        }
+
+        if (successful and size == 0) {
+            finished = true;
+            successful = parser.finish();
+        }
+
+        failed = not successful;
+        return successful;
+    }
+};
+
+
+record_reader::record_reader(std::string filename, bool use_mmap)
+    : impl(new impl_t())
+{
+    if (not impl->input.open_file(filename.c_str(), use_mmap)) {
+        impl->failed = true;
+    }
+}
+
+
+record_reader::~record_reader() = default;
+record_reader::record_reader(record_reader&&) = default;
+record_reader& record_reader::operator=(record_reader&&) = default;
+
+
+bool record_reader::next(son& record) {
+    while (not impl->parser.next_value(record)) {
+        if (impl->failed or impl->finished) {
+            return false;
+        }
+
+        impl->feed_more();
+    }
+
+    return true;
+}
+
+
+bool record_reader::failed() const {
+    return impl->failed;
+}
+
+
+record_writer::record_writer(FILE* output)
+    : output(output)
+{}
+
+
+record_writer::record_writer(std::string filename)
+    : output(fopen(filename.c_str(), "wb"))
+    , owns_output(true)
+{}
+
+
+record_writer::~record_writer() {
+    if (owns_output and output) {
+        fclose(output);
+    }
+}
+
+
+// Key that is lexed back as the same identifier.
+static bool is_identifier(std::string_view key) {
+    if (key.empty() or not is_valid_identifier_head(key[0])) {
+        return false;
+    }
+
+    for (char c : key) {
+        if (not is_valid_identifier_body(c)) return false;
+    }
+
+    return keyword_or_identifier(key.data(), key.size()) == TOKEN_IDENTIFIER;
+}
+
+
+// Whether the record is read back as it is: numbers are finite and keys are identifiers.
+static bool can_be_read_back(const son& record) {
+    std::vector<const son*> unvisited = { &record };
+
+    while (not unvisited.empty()) {
+        const son* value = unvisited.back();
+        unvisited.pop_back();
+
+        if (value->is_floating() and not isfinite(value->get_floating())) {
+            return false;
+        }
+
+        if (value->is_object()) {
+            for (auto [key, child] : value->pairs()) {
+                if (not is_identifier(key)) return false;
+                unvisited.push_back(&child);
+            }
+        } else if (value->is_array()) {
+            for (const son& child : *value) {
+                unvisited.push_back(&child);
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool record_writer::write(const son& record) {
+    if (not good()) {
+        return false;
+    }
+
+    if (not can_be_read_back(record)) {
+        failed = true;
+        return false;
+    }
+
+    print_options options;
+    options.output = output;
+    options.multiline = print_options::multiline_t::disabled;
+    options.exact_floats = true;
+
+    pretty_print(record, options);
+    if (fputc('\n', output) == EOF) {
+        failed = true;
+    }
+
+    return not failed;
+}
+
+
+bool record_writer::flush() {
+    if (not good() or fflush(output) != 0) {
+        failed = true;
+    }
+
+    return not failed;
+}
+
+
+} // jslavic
@@ -0,0 +1,662 @@
+#include "simd.hpp"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SON_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+namespace jslavic {
+
+
+static inline bool is_space_byte(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+static inline bool is_newline_byte(char c) { return c == '\n' || c == '\r'; }
+static inline bool is_string_special_byte(char c) { return c == '"' || c == '\\' || is_newline_byte(c) || c == '\0'; }
+static inline bool is_structural_byte(char c) {
+    return c == '"' || c == '/' || c == '{' || c == '}' || c == '[' || c == ']' || c == ';' || c == ',';
+}
+
+
+static const char* skip_spaces_scalar(const char* p, const char* end) {
+    while (p < end && is_space_byte(*p)) { p++; }
+    return p;
+}
+
+
+static const char* find_newline_scalar(const char* p, const char* end) {
+    while (p < end && not is_newline_byte(*p)) { p++; }
+    return p;
+}
+
+
+static const char* find_string_special_scalar(const char* p, const char* end) {
+    while (p < end && not is_string_special_byte(*p)) { p++; }
+    return p;
+}
+
+
+static const char* find_structural_scalar(const char* p, const char* end) {
+    while (p < end && not is_structural_byte(*p)) { p++; }
+    return p;
+}
+
+
+// Length of the valid UTF-8 sequence that starts at p, or 0 if it is not valid: overlong forms,
+// surrogates, code points above U+10FFFF and sequences cut by end are not.
+static size_t utf8_sequence_length(const uint8_t* p, const uint8_t* end) {
+    uint8_t c = p[0];
+
+    if (c < 0x80) return 1;
+    if (c < 0xC2) return 0;
+    if (c < 0xE0) return (end - p >= 2 && (p[1] & 0xC0) == 0x80) ? 2 : 0;
+
+    if (c < 0xF0) {
+        uint8_t low = (c == 0xE0) ? 0xA0 : 0x80;
+        uint8_t high = (c == 0xED) ? 0x9F : 0xBF;
+        return (end - p >= 3 && p[1] >= low && p[1] <= high && (p[2] & 0xC0) == 0x80) ? 3 : 0;
+    }
+
+    if (c < 0xF5) {
+        uint8_t low = (c == 0xF0) ? 0x90 : 0x80;
+        uint8_t high = (c == 0xF4) ? 0x8F : 0xBF;
+        return (end - p >= 4 && p[1] >= low && p[1] <= high && (p[2] & 0xC0) == 0x80 && (p[3] & 0xC0) == 0x80) ? 4 : 0;
+    }
+
+    return 0;
+}
+
+
+static const char* find_invalid_utf8_scalar(const char* p, const char* end) {
+    while (p < end) {
+        if ((uint8_t)*p < 0x80) {
+            p++;
+            continue;
+        }
+
+        size_t length = utf8_sequence_length((const uint8_t*)p, (const uint8_t*)end);
+        if (length == 0) return p;
+        p += length;
+    }
+
+    return end;
+}
+
+
+// Start of the sequence that p is in, if the text before p is valid UTF-8.
+static const char* utf8_sequence_start(const char* begin, const char* p) {
+    for (int i = 0; i < 3 && p > begin && ((uint8_t)p[-1] & 0xC0) == 0x80; i++) { p--; }
+    if (p > begin && (uint8_t)p[-1] >= 0xC0) { p--; }
+    return p;
+}
+
+
+#ifdef SON_HAS_X86_SIMD
+
+static const char* skip_spaces_sse2(const char* p, const char* end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i newline = _mm_or_si128(_mm_cmpeq_epi8(block, lf), _mm_cmpeq_epi8(block, cr));
+        __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab));
+
+        uint32_t spaces = (uint32_t)_mm_movemask_epi8(_mm_or_si128(blank, newline));
+        if (spaces != 0xFFFF) {
+            return p + __builtin_ctz(~spaces);
+        }
+        p += 16;
+    }
+
+    return skip_spaces_scalar(p, end);
+}
+
+
+static const char* find_newline_sse2(const char* p, const char* end) {
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i newline = _mm_or_si128(_mm_cmpeq_epi8(block, lf), _mm_cmpeq_epi8(block, cr));
+
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(newline);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+
+    return find_newline_scalar(p, end);
+}
+
+
+static const char* find_string_special_sse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i zero = _mm_setzero_si128();
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, lf), _mm_cmpeq_epi8(block, cr)), _mm_cmpeq_epi8(block, zero)));
+
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+
+    return find_string_special_scalar(p, end);
+}
+
+
+// '{' and '}' differ from '[' and ']' only in bit 0x20, so one compare after OR-ing it in finds all four.
+static const char* find_structural_sse2(const char* p, const char* end) {
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i brace_open = _mm_set1_epi8('{');
+    const __m128i brace_close = _mm_set1_epi8('}');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i semicolon = _mm_set1_epi8(';');
+    const __m128i comma = _mm_set1_epi8(',');
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i folded = _mm_or_si128(block, case_bit);
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, brace_open), _mm_cmpeq_epi8(folded, brace_close)),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, slash)),
+                _mm_or_si128(_mm_cmpeq_epi8(block, semicolon), _mm_cmpeq_epi8(block, comma))));
+
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+
+    return find_structural_scalar(p, end);
+}
+
+
+// Fallback for processors without SSSE3, which has no byte shuffle for the lookups: blocks of ASCII
+// are skipped, others are checked one sequence at a time up to the end of the block.
+static const char* find_invalid_utf8_sse2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        if (_mm_movemask_epi8(block) == 0) {
+            p += 16;
+            continue;
+        }
+
+        const char* block_end = p + 16;
+        while (p < block_end) {
+            if ((uint8_t)*p < 0x80) {
+                p++;
+                continue;
+            }
+
+            size_t length = utf8_sequence_length((const uint8_t*)p, (const uint8_t*)end);
+            if (length == 0) return p;
+            p += length;
+        }
+    }
+
+    return find_invalid_utf8_scalar(p, end);
+}
+
+
+__attribute__((target("avx2")))
+static const char* skip_spaces_avx2(const char* p, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i newline = _mm256_or_si256(_mm256_cmpeq_epi8(block, lf), _mm256_cmpeq_epi8(block, cr));
+        __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab));
+
+        uint32_t spaces = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(blank, newline));
+        if (spaces != 0xFFFFFFFF) {
+            return p + __builtin_ctz(~spaces);
+        }
+        p += 32;
+    }
+
+    return skip_spaces_sse2(p, end);
+}
+
+
+__attribute__((target("avx2")))
+static const char* find_newline_avx2(const char* p, const char* end) {
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i newline = _mm256_or_si256(_mm256_cmpeq_epi8(block, lf), _mm256_cmpeq_epi8(block, cr));
+
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(newline);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+
+    return find_newline_sse2(p, end);
+}
+
+
+__attribute__((target("avx2")))
+static const char* find_string_special_avx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i zero = _mm256_setzero_si256();
+
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, lf), _mm256_cmpeq_epi8(block, cr)), _mm256_cmpeq_epi8(block, zero)));
+
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+
+    return find_string_special_sse2(p, end);
+}
+
+
+__attribute__((target("avx2")))
+static const char* find_structural_avx2(const char* p, const char* end) {
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i brace_open = _mm256_set1_epi8('{');
+    const __m256i brace_close = _mm256_set1_epi8('}');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i semicolon = _mm256_set1_epi8(';');
+    const __m256i comma = _mm256_set1_epi8(',');
+
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i folded = _mm256_or_si256(block, case_bit);
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, brace_open), _mm256_cmpeq_epi8(folded, brace_close)),
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, slash)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, semicolon), _mm256_cmpeq_epi8(block, comma))));
+
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+
+    return find_structural_sse2(p, end);
+}
+
+
+// Validation of whole blocks with table lookups, from "Validating UTF-8 In Less Than One Instruction
+// Per Byte" by Keiser and Lemire. Every byte is classified by its high nibble, the low nibble of the
+// byte before it, and the high nibble of the byte before that; the three lookups have a common bit
+// only for pairs of bytes that cannot follow each other. Blocks of ASCII only check that nothing
+// before them is left unfinished. The first invalid sequence is found by the scalar code.
+
+static const uint8_t TOO_SHORT = 1 << 0;  // Lead byte or ASCII followed by a lead byte or ASCII, where a continuation is due.
+static const uint8_t TOO_LONG = 1 << 1;   // ASCII followed by a continuation.
+static const uint8_t OVERLONG_3 = 1 << 2; // 11100000 100_____
+static const uint8_t TOO_LARGE = 1 << 3;  // Above U+10FFFF.
+static const uint8_t SURROGATE = 1 << 4;  // 11101101 101_____
+static const uint8_t OVERLONG_2 = 1 << 5; // 1100000_ 10______
+static const uint8_t TOO_LARGE_1000 = 1 << 6;
+static const uint8_t OVERLONG_4 = 1 << 6; // 11110000 1000____
+static const uint8_t TWO_CONTS = 1 << 7;  // Two continuations, checked by the lengths of sequences instead.
+static const uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+
+__attribute__((target("avx2")))
+static inline __m256i lookup_16(__m256i index, uint8_t t0, uint8_t t1, uint8_t t2, uint8_t t3,
+    uint8_t t4, uint8_t t5, uint8_t t6, uint8_t t7, uint8_t t8, uint8_t t9, uint8_t t10, uint8_t t11,
+    uint8_t t12, uint8_t t13, uint8_t t14, uint8_t t15)
+{
+    __m256i table = _mm256_setr_epi8(
+        t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15,
+        t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15);
+    return _mm256_shuffle_epi8(table, index);
+}
+
+
+__attribute__((target("avx2")))
+static inline __m256i high_nibbles(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+
+// Bytes of the block moved by n positions, with the last bytes of the previous block in front.
+template <int N>
+__attribute__((target("avx2")))
+static inline __m256i previous_bytes(__m256i input, __m256i previous) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+}
+
+
+__attribute__((target("avx2")))
+static __m256i utf8_errors(__m256i input, __m256i previous) {
+    __m256i prev1 = previous_bytes<1>(input, previous);
+
+    __m256i byte_1_high = lookup_16(high_nibbles(prev1),
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+
+    __m256i byte_1_low = lookup_16(_mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)),
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+
+    __m256i byte_2_high = lookup_16(high_nibbles(input),
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // Third and fourth bytes of sequences have to be continuations, and nothing else may be.
+    __m256i third = _mm256_subs_epu8(previous_bytes<2>(input, previous), _mm256_set1_epi8(char(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(previous_bytes<3>(input, previous), _mm256_set1_epi8(char(0xF0 - 0x80)));
+    __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(char(0x80)));
+
+    return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+
+__attribute__((target("avx2")))
+static const char* find_invalid_utf8_avx2(const char* p, const char* end) {
+    const char* begin = p;
+
+    // Lead bytes in the last three positions that need more bytes than the block has left.
+    const __m256i max_complete = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+
+    __m256i previous = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i errors = incomplete;
+
+        if (_mm256_movemask_epi8(block) != 0) {
+            errors = utf8_errors(block, previous);
+            incomplete = _mm256_subs_epu8(block, max_complete);
+        } else {
+            incomplete = _mm256_setzero_si256();
+        }
+
+        if (not _mm256_testz_si256(errors, errors)) {
+            return find_invalid_utf8_scalar(utf8_sequence_start(begin, p), end);
+        }
+
+        previous = block;
+        p += 32;
+    }
+
+    if (p == end) {
+        return _mm256_testz_si256(incomplete, incomplete) ? end : find_invalid_utf8_scalar(utf8_sequence_start(begin, p), end);
+    }
+
+    // Short strings are mostly the tail. It is checked as one more block padded with zeros,
+    // and a sequence that is cut by the end is followed by a zero, which is an error.
+    char tail[32] = {};
+    memcpy(tail, p, end - p);
+
+    __m256i block = _mm256_loadu_si256((const __m256i*)tail);
+    __m256i errors = incomplete;
+    if (_mm256_movemask_epi8(block) != 0) {
+        errors = _mm256_or_si256(errors, utf8_errors(block, previous));
+    }
+
+    if (_mm256_testz_si256(errors, errors)) {
+        return end;
+    }
+    return find_invalid_utf8_scalar(utf8_sequence_start(begin, p), end);
+}
+
+
+// Same lookups on 16 bytes, for processors with SSSE3 but without AVX2. SSSE3 has no test for
+// a zero register, so errors are compared with zero instead.
+
+__attribute__((target("ssse3")))
+static inline __m128i lookup_16(__m128i index, uint8_t t0, uint8_t t1, uint8_t t2, uint8_t t3,
+    uint8_t t4, uint8_t t5, uint8_t t6, uint8_t t7, uint8_t t8, uint8_t t9, uint8_t t10, uint8_t t11,
+    uint8_t t12, uint8_t t13, uint8_t t14, uint8_t t15)
+{
+    __m128i table = _mm_setr_epi8(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15);
+    return _mm_shuffle_epi8(table, index);
+}
+
+
+__attribute__((target("ssse3")))
+static inline __m128i high_nibbles(__m128i v) {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+
+template <int N>
+__attribute__((target("ssse3")))
+static inline __m128i previous_bytes(__m128i input, __m128i previous) {
+    return _mm_alignr_epi8(input, previous, 16 - N);
+}
+
+
+__attribute__((target("ssse3")))
+static inline bool is_zero(__m128i v) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+}
+
+
+__attribute__((target("ssse3")))
+static __m128i utf8_errors(__m128i input, __m128i previous) {
+    __m128i prev1 = previous_bytes<1>(input, previous);
+
+    __m128i byte_1_high = lookup_16(high_nibbles(prev1),
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+
+    __m128i byte_1_low = lookup_16(_mm_and_si128(prev1, _mm_set1_epi8(0x0F)),
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+
+    __m128i byte_2_high = lookup_16(high_nibbles(input),
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    __m128i third = _mm_subs_epu8(previous_bytes<2>(input, previous), _mm_set1_epi8(char(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(previous_bytes<3>(input, previous), _mm_set1_epi8(char(0xF0 - 0x80)));
+    __m128i must_be_continuation = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+
+    return _mm_xor_si128(must_be_continuation, special_cases);
+}
+
+
+__attribute__((target("ssse3")))
+static const char* find_invalid_utf8_ssse3(const char* p, const char* end) {
+    const char* begin = p;
+
+    const __m128i max_complete = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+
+    __m128i previous = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i errors = incomplete;
+
+        if (_mm_movemask_epi8(block) != 0) {
+            errors = utf8_errors(block, previous);
+            incomplete = _mm_subs_epu8(block, max_complete);
+        } else {
+            incomplete = _mm_setzero_si128();
+        }
+
+        if (not is_zero(errors)) {
+            return find_invalid_utf8_scalar(utf8_sequence_start(begin, p), end);
+        }
+
+        previous = block;
+        p += 16;
+    }
+
+    if (p == end) {
+        return is_zero(incomplete) ? end : find_invalid_utf8_scalar(utf8_sequence_start(begin, p), end);
+    }
+
+    char tail[16] = {};
+    memcpy(tail, p, end - p);
+
+    __m128i block = _mm_loadu_si128((const __m128i*)tail);
+    __m128i errors = incomplete;
+    if (_mm_movemask_epi8(block) != 0) {
+        errors = _mm_or_si128(errors, utf8_errors(block, previous));
+    }
+
+    if (is_zero(errors)) {
+        return end;
+    }
+    return find_invalid_utf8_scalar(utf8_sequence_start(begin, p), end);
+}
+
+#endif // SON_HAS_X86_SIMD
+
+
+struct kernels_t {
+    const char* (*skip_spaces)(const char*, const char*) = skip_spaces_scalar;
+    const char* (*find_newline)(const char*, const char*) = find_newline_scalar;
+    const char* (*find_string_special)(const char*, const char*) = find_string_special_scalar;
+    const char* (*find_structural)(const char*, const char*) = find_structural_scalar;
+    const char* (*find_invalid_utf8)(const char*, const char*) = find_invalid_utf8_scalar;
+};
+
+
+static kernels_t select_kernels() {
+    kernels_t result;
+
+#ifdef SON_HAS_X86_SIMD
+    result.skip_spaces = skip_spaces_sse2;
+    result.find_newline = find_newline_sse2;
+    result.find_string_special = find_string_special_sse2;
+    result.find_structural = find_structural_sse2;
+    result.find_invalid_utf8 = find_invalid_utf8_sse2;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        result.find_invalid_utf8 = find_invalid_utf8_ssse3;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        result.skip_spaces = skip_spaces_avx2;
+        result.find_newline = find_newline_avx2;
+        result.find_string_special = find_string_special_avx2;
+        result.find_structural = find_structural_avx2;
+        result.find_invalid_utf8 = find_invalid_utf8_avx2;
+    }
+#endif
+
+    return result;
+}
+
+
+// Selected on the first use, so parsing also works while other static objects are initialized.
+static const kernels_t& kernels() {
+    static const kernels_t selected = select_kernels();
+    return selected;
+}
+
+
+const char* skip_spaces(const char* p, const char* end) {
+    return kernels().skip_spaces(p, end);
+}
+
+
+const char* find_newline(const char* p, const char* end) {
+    return kernels().find_newline(p, end);
+}
+
+
+const char* find_string_special(const char* p, const char* end) {
+    return kernels().find_string_special(p, end);
+}
+
+
+const char* find_structural(const char* p, const char* end) {
+    return kernels().find_structural(p, end);
+}
+
+
+const char* find_invalid_utf8(const char* p, const char* end) {
+    return kernels().find_invalid_utf8(p, end);
+}
+
+
+} // jslavic
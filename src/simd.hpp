@@ -0,0 +1,36 @@
+#ifndef SON_SIMD_HPP
+#define SON_SIMD_HPP
+
+#include <stddef.h>
+
+
+namespace jslavic {
+
+
+// Block scanners used by the lexer. Each of them has a scalar version and
+// SSE2/AVX2 versions on x86-64, picked once at startup depending on the CPU.
+
+
+// Skips ' ', '\t', '\n' and '\r' starting at p. Returns the first character that is not a space, or end.
+const char* skip_spaces(const char* p, const char* end);
+
+// Returns position of the first '\n' or '\r' starting at p, or end.
+const char* find_newline(const char* p, const char* end);
+
+// Returns position of the first character that ends a plain run inside a quoted string:
+// '"', '\\', '\n', '\r' or '\0'. Returns end if there is none.
+const char* find_string_special(const char* p, const char* end);
+
+// Returns position of the first character that changes the structure of the text:
+// '"', '/', '{', '}', '[', ']', ';' or ','. Returns end if there is none.
+const char* find_structural(const char* p, const char* end);
+
+// Returns position of the first byte that does not start a valid UTF-8 sequence, or end if the text
+// is valid. Overlong forms, surrogates, code points above U+10FFFF and cut sequences are not valid.
+const char* find_invalid_utf8(const char* p, const char* end);
+
+
+} // jslavic
+
+
+#endif // SON_SIMD_HPP
@@ -0,0 +1,193 @@
+#include "structure.hpp"
+
+
+namespace jslavic {
+
+
+const char* skip_blank(const char* p, const char* end) {
+    while (true) {
+        p = skip_spaces(p, end);
+
+        if (end - p >= 2 and p[0] == '/' and p[1] == '/') {
+            p = find_newline(p + 2, end);
+            continue;
+        }
+
+        return p;
+    }
+}
+
+
+const char* skip_string(const char* p, const char* end) {
+    p++; // Skip double quote.
+
+    while (true) {
+        p = find_string_special(p, end);
+        if (p >= end) return nullptr;
+
+        if (*p == '"') return p + 1;
+        if (*p == '\\') {
+            p += escape_skip(p, end);
+            continue;
+        }
+
+        return nullptr;
+    }
+}
+
+
+bool split_top_level(span text, size_t count, top_level_parts& result) {
+    const char* end = text.begin + text.size;
+    const char* p = skip_blank(text.begin, end);
+
+    if (p == end) {
+        return false;
+    }
+
+    // Depth of pairs or elements of the top level: 0 for an object without braces.
+    size_t inner_depth = 0;
+    if (*p == '{' or *p == '[') {
+        result.is_object = (*p == '{');
+        inner_depth = 1;
+        p++;
+    } else if (is_valid_identifier_head(*p)) {
+        result.is_object = true;
+    } else {
+        return false;
+    }
+
+    const char* begin = p;
+    const char* inner_end = end;
+    char separator = result.is_object ? ';' : ',';
+
+    size_t step = (end - begin) / (count > 0 ? count : 1);
+    const char* target = begin + step;
+    const char* part_begin = begin;
+
+    result.parts.clear();
+
+    size_t depth = inner_depth;
+    while ((p = find_structural(p, end)) < end) {
+        char c = *p;
+        const char* split = nullptr;
+
+        switch (c) {
+            case '"': {
+                p = skip_string(p, end);
+                if (not p) return false;
+                continue;
+            }
+            case '/': {
+                if (end - p < 2 or p[1] != '/') return false;
+                p = find_newline(p + 2, end);
+                continue;
+            }
+            case '{':
+            case '[': {
+                depth += 1;
+                p++;
+                continue;
+            }
+            case '}':
+            case ']': {
+                if (depth == inner_depth) {
+                    // Only braced top level may be closed, and only by its own bracket.
+                    if (inner_depth == 0 or c != (result.is_object ? '}' : ']')) return false;
+                    inner_end = p;
+                    p = skip_blank(p + 1, end);
+                    if (p != end) return false;
+                    break;
+                }
+
+                depth -= 1;
+                p++;
+                if (depth == inner_depth) split = p;
+                break;
+            }
+            default: {
+                p++;
+                if (depth == inner_depth and c == separator) split = p;
+                break;
+            }
+        }
+
+        if (split and split >= target and result.parts.size() + 1 < count) {
+            result.parts.push_back(span(part_begin, split - part_begin));
+            part_begin = split;
+            target = split + step;
+        }
+    }
+
+    // Braced top level has to be closed, the one without braces has to end at depth zero.
+    if (depth != inner_depth or (inner_depth > 0 and inner_end == end)) {
+        return false;
+    }
+
+    result.parts.push_back(span(part_begin, inner_end - part_begin));
+    return true;
+}
+
+
+const char* skip_container(const char* p, const char* end, size_t max_depth) {
+    size_t depth = 0;
+
+    while ((p = find_structural(p, end)) < end) {
+        switch (*p) {
+            case '"': {
+                p = skip_string(p, end);
+                if (not p) return nullptr;
+                continue;
+            }
+            case '/': {
+                if (end - p >= 2 and p[1] == '/') {
+                    p = find_newline(p + 2, end);
+                    continue;
+                }
+                break;
+            }
+            case '{':
+            case '[': {
+                depth += 1;
+                if (depth > max_depth) return nullptr;
+                break;
+            }
+            case '}':
+            case ']': {
+                depth -= 1;
+                if (depth == 0) return p + 1;
+                break;
+            }
+        }
+
+        p++;
+    }
+
+    return nullptr;
+}
+
+
+const char* skip_value(const char* p, const char* end) {
+    if (p == end) {
+        return nullptr;
+    }
+
+    switch (char_classes[(uint8_t)*p]) {
+        case CHAR_QUOTE:
+            return skip_string(p, end);
+        case CHAR_NUMBER:
+        case CHAR_IDENTIFIER: {
+            const char* q = p;
+            while (q < end and (char_classes[(uint8_t)*q] == CHAR_NUMBER or char_classes[(uint8_t)*q] == CHAR_IDENTIFIER)) { q++; }
+            return q;
+        }
+    }
+
+    if (*p == '{' or *p == '[') {
+        return skip_container(p, end);
+    }
+
+    return nullptr;
+}
+
+
+} // jslavic
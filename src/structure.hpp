@@ -0,0 +1,45 @@
+#ifndef SON_STRUCTURE_HPP
+#define SON_STRUCTURE_HPP
+
+#include "lexer.hpp"
+#include <vector>
+
+
+namespace jslavic {
+
+
+// Skips spaces and comments.
+const char* skip_blank(const char* p, const char* end);
+
+// Returns position after the closing quote of the string starting at p, or nullptr if it is not closed properly.
+const char* skip_string(const char* p, const char* end);
+
+
+// Parts of the top level object or array that can be parsed independently. Every part is a sequence
+// of whole pairs or elements. Parts are found by scanning only structural characters, see find_structural.
+struct top_level_parts {
+    bool is_object = false;
+    std::vector<span> parts;
+};
+
+
+// Splits the inside of a single top level object (with or without braces) or array into at most
+// `count` parts of similar size. Returns false if the text has other top level shape, or if its
+// structure is broken; such text is left to the sequential parser, which reports errors.
+bool split_top_level(span text, size_t count, top_level_parts& result);
+
+// Returns position after the bracket that closes the object or array starting at p, or nullptr
+// if it is not closed, or if objects and arrays in it, itself included, are nested deeper than max_depth.
+// Strings and comments are skipped, nothing else is checked: the skipped text is parsed properly
+// only if it is needed later.
+const char* skip_container(const char* p, const char* end, size_t max_depth = SIZE_MAX);
+
+// Returns position after the value starting at p, or nullptr if there is no value. Like skip_container,
+// it only finds where the value ends: numbers and keywords are not decoded.
+const char* skip_value(const char* p, const char* end);
+
+
+} // jslavic
+
+
+#endif // SON_STRUCTURE_HPP
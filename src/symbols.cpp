@@ -0,0 +1,52 @@
+#include <value.hpp>
+#include <mutex>
+#include <unordered_map>
+#include <string.h>
+
+
+namespace jslavic {
+
+
+// Every interned key has its characters here once, and an id that no other key has.
+// Nothing is ever removed, so interned keys stay valid wherever they are copied.
+struct symbol_table {
+    static const size_t capacity = 64 * 1024; // Keys of untrusted input cannot grow the table without end.
+
+    std::mutex mutex;
+    std::pmr::monotonic_buffer_resource characters;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+
+// Not destroyed at exit, values that are destroyed later may still have its keys.
+static symbol_table& symbols() {
+    static symbol_table* table = new symbol_table();
+    return *table;
+}
+
+
+son::key_t intern(std::string_view key) {
+    symbol_table& table = symbols();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto it = table.ids.find(key);
+    if (it != table.ids.end()) {
+        return son::key_t(it->first, it->second);
+    }
+
+    if (table.ids.size() >= symbol_table::capacity) {
+        return son::key_t(key);
+    }
+
+    char* data = (char*)table.characters.allocate(key.size(), 1);
+    memcpy(data, key.data(), key.size());
+
+    std::string_view stored(data, key.size());
+    uint32_t id = uint32_t(table.ids.size() + 1);
+    table.ids.emplace(stored, id);
+
+    return son::key_t(stored, id);
+}
+
+
+} // jslavic
@@ -0,0 +1,54 @@
+#ifndef SON_THREADS_HPP
+#define SON_THREADS_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+namespace jslavic {
+
+
+// Zero means one thread per core.
+inline size_t thread_count(size_t requested) {
+    if (requested > 0) {
+        return requested;
+    }
+
+    size_t cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+
+// Runs task(i, worker) for i from 0 to count - 1 on up to `threads` threads, the calling thread is one of them.
+// Worker is the index of the thread, below `threads`, so tasks can use state of their own thread.
+// Threads take the next index as soon as they are done, so uneven tasks are balanced.
+template <typename Task>
+void run_parallel(size_t count, size_t threads, Task&& task) {
+    std::atomic<size_t> next(0);
+
+    auto worker = [&](size_t worker_index) {
+        size_t i;
+        while ((i = next.fetch_add(1)) < count) {
+            task(i, worker_index);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads and t < count; t++) {
+        pool.emplace_back(worker, t);
+    }
+
+    worker(0);
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+
+} // jslavic
+
+
+#endif // SON_THREADS_HPP
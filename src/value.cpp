@@ -1,7 +1,11 @@
 #include <value.hpp>
+#include "hash.hpp"
 #include <algorithm>
+#include <charconv>
 #include <unordered_map>
 #include <inttypes.h>
+#include <string.h>
+#include <stddef.h>
 
 
 namespace jslavic {
@@ -26,6 +30,233 @@ struct custom_type_factory {
 };
 
 
+// Storage of strings, objects and arrays is allocated from the same resource as their contents,
+// so it is freed by the resource that its allocator remembers.
+template <typename T, typename... Args>
+static T* create(std::pmr::memory_resource* resource, Args&&... args) {
+    void* memory = resource->allocate(sizeof(T), alignof(T));
+    return new (memory) T(std::forward<Args>(args)..., resource);
+}
+
+
+template <typename T>
+static void destroy(void* storage) {
+    T* p = (T*)storage;
+    std::pmr::memory_resource* resource = p->get_allocator().resource();
+
+    p->~T();
+    resource->deallocate(p, sizeof(T), alignof(T));
+}
+
+
+son::key_t::key_t() noexcept
+    : m_inline()
+{}
+
+
+son::key_t::key_t(std::string_view stored, uint32_t id) noexcept
+    : m_size(uint32_t(stored.size()))
+    , m_id(id)
+{
+    m_outside.data = stored.data();
+    m_outside.resource = nullptr;
+}
+
+
+son::key_t::key_t(std::string_view s, const allocator_type& allocator)
+    : m_size(uint32_t(s.size()))
+{
+    if (s.size() <= inline_capacity) {
+        memcpy(m_inline, s.data(), s.size());
+        return;
+    }
+
+    std::pmr::memory_resource* resource = allocator.resource();
+    char* data = (char*)resource->allocate(s.size(), 1);
+    memcpy(data, s.data(), s.size());
+
+    m_outside.data = data;
+    m_outside.resource = resource;
+}
+
+
+son::key_t::key_t(const key_t& other, const allocator_type& allocator)
+    : key_t()
+{
+    if (other.m_id != 0) {
+        m_size = other.m_size;
+        m_id = other.m_id;
+        m_outside = other.m_outside;
+        return;
+    }
+
+    key_t(other.view(), allocator).swap(*this);
+}
+
+
+son::key_t::key_t(key_t&& other) noexcept
+    : key_t()
+{
+    other.swap(*this);
+}
+
+
+son::key_t::key_t(key_t&& other, const allocator_type&) noexcept
+    : key_t()
+{
+    other.swap(*this);
+}
+
+
+son::key_t::~key_t() {
+    if (not is_inline() and m_outside.resource) {
+        m_outside.resource->deallocate((void*)m_outside.data, m_size, 1);
+    }
+}
+
+
+son::key_t& son::key_t::operator=(const key_t& other) {
+    key_t(other).swap(*this);
+    return *this;
+}
+
+
+son::key_t& son::key_t::operator=(key_t&& other) noexcept {
+    other.swap(*this);
+    return *this;
+}
+
+
+void son::key_t::swap(key_t& other) noexcept {
+    char bytes[sizeof(key_t)];
+    memcpy(bytes, (void*)this, sizeof(key_t));
+    memcpy((void*)this, (void*)&other, sizeof(key_t));
+    memcpy((void*)&other, bytes, sizeof(key_t));
+}
+
+
+// Open addressing table of positions of pairs + 1, free slots are 0. Only the first of pairs
+// with equal keys is in it. Kept at most half full. Indexes always take memory from the heap:
+// lookups on any thread may make one, and the resource of the object may be an arena.
+struct son::object_t::index_t {
+    size_t slot_count;
+
+    uint32_t* slots() { return reinterpret_cast<uint32_t*>(this + 1); }
+};
+
+
+son::object_t::~object_t() {
+    drop_index();
+}
+
+
+const son::object_t::value_type* son::object_t::find(std::string_view key) const {
+    if (size() < index_threshold) {
+        for (auto& pair : *this) {
+            if (pair.first == key) return &pair;
+        }
+        return nullptr;
+    }
+
+    return find_indexed(key, key);
+}
+
+
+const son::object_t::value_type* son::object_t::find(const key_t& key) const {
+    if (size() < index_threshold) {
+        for (auto& pair : *this) {
+            if (pair.first == key) return &pair;
+        }
+        return nullptr;
+    }
+
+    return find_indexed(key, key.view());
+}
+
+
+template <typename Key>
+const son::object_t::value_type* son::object_t::find_indexed(const Key& key, std::string_view characters) const {
+    index_t* index = m_index.load(std::memory_order_acquire);
+
+    if (not index) {
+        // Other threads may be making one at the same time, the first one that is done is kept.
+        index_t* made = make_index(size() * 2);
+        if (m_index.compare_exchange_strong(index, made, std::memory_order_acq_rel)) {
+            index = made;
+        } else {
+            ::operator delete(made);
+        }
+    }
+
+    uint32_t* slots = index->slots();
+    size_t mask = index->slot_count - 1;
+    size_t i = hash_key(characters) & mask;
+
+    while (slots[i] != 0) {
+        const value_type& pair = (*this)[slots[i] - 1];
+        if (pair.first == key) return &pair;
+        i = (i + 1) & mask;
+    }
+
+    return nullptr;
+}
+
+
+void son::object_t::index_last() {
+    index_t* index = m_index.load(std::memory_order_relaxed);
+    if (not index) {
+        return; // Made by the first lookup.
+    }
+
+    if (size() * 2 > index->slot_count) {
+        m_index.store(make_index(index->slot_count * 2), std::memory_order_release);
+        ::operator delete(index);
+        return;
+    }
+
+    insert_position(index, size() - 1);
+}
+
+
+void son::object_t::drop_index() {
+    ::operator delete(m_index.exchange(nullptr, std::memory_order_relaxed));
+}
+
+
+son::object_t::index_t* son::object_t::make_index(size_t slot_count) const {
+    size_t count = 64;
+    while (count < slot_count) {
+        count *= 2;
+    }
+
+    index_t* index = (index_t*)::operator new(sizeof(index_t) + count * sizeof(uint32_t));
+    index->slot_count = count;
+    memset(index->slots(), 0, count * sizeof(uint32_t));
+
+    for (size_t position = 0; position < size(); position++) {
+        insert_position(index, position);
+    }
+
+    return index;
+}
+
+
+void son::object_t::insert_position(index_t* index, size_t position) const {
+    std::string_view key = (*this)[position].first.view();
+
+    uint32_t* slots = index->slots();
+    size_t mask = index->slot_count - 1;
+    size_t i = hash_key(key) & mask;
+
+    while (slots[i] != 0) {
+        if ((*this)[slots[i] - 1].first == key) return; // Lookups find the first one.
+        i = (i + 1) & mask;
+    }
+
+    slots[i] = uint32_t(position + 1);
+}
+
+
 son::~son() {
     switch (m_type) {
         case type_t::null:
@@ -33,9 +264,9 @@ son::~son() {
         case type_t::integer:
         case type_t::floating:
             break;
-        case type_t::string: delete (string_t*)m_value.storage; break;
-        case type_t::object: delete (object_t*)m_value.storage; break;
-        case type_t::array:  delete (array_t*)m_value.storage;  break;
+        case type_t::string: if (m_short_size == long_string) destroy<string_t>(m_value.storage); break;
+        case type_t::object: destroy<object_t>(m_value.storage); break;
+        case type_t::array:  destroy<array_t>(m_value.storage);  break;
         // case type_t::custom: // @todo
     }
 }
@@ -44,6 +275,10 @@ son::~son() {
 son::son()
     : m_type(type_t::null)
 {
+    static_assert(sizeof(son) == 16, "son is two words");
+    static_assert(offsetof(son, m_short_tail) == sizeof(value_t), "short strings are contiguous");
+    static_assert(offsetof(son, m_short_size) == short_string_capacity, "short strings are contiguous");
+
     m_value.storage = nullptr;
 }
 
@@ -54,6 +289,11 @@ son::son(std::nullptr_t) noexcept
 
 
 son::son(type_t t) noexcept
+    : son(t, std::pmr::get_default_resource())
+{}
+
+
+son::son(type_t t, std::pmr::memory_resource* resource) noexcept
     : son()
 {
     m_type = t;
@@ -62,9 +302,9 @@ son::son(type_t t) noexcept
     case type_t::boolean: m_value.boolean = false; break;
     case type_t::integer: m_value.integer = 0; break;
     case type_t::floating: m_value.floating = 0.0; break;
-    case type_t::string: m_value.storage = new string_t(); break;
-    case type_t::object: m_value.storage = new object_t(); break;
-    case type_t::array:  m_value.storage = new array_t();  break;
+    case type_t::string: m_short_size = 0; break;
+    case type_t::object: m_value.storage = create<object_t>(resource); break;
+    case type_t::array:  m_value.storage = create<array_t>(resource);  break;
     // case type_t::custom: // @todo
     }
 }
@@ -89,13 +329,25 @@ son::son(floating_t v) noexcept {
 
 
 son::son(const char* s) noexcept
-    : son(std::string(s))
+    : son(std::string_view(s), std::pmr::get_default_resource())
+{}
+
+
+son::son(std::string s) noexcept
+    : son(std::string_view(s), std::pmr::get_default_resource())
 {}
 
 
-son::son(std::string s) noexcept {
+son::son(std::string_view s, std::pmr::memory_resource* resource) noexcept {
     m_type = type_t::string;
-    m_value.storage = new string_t(std::move(s));
+
+    if (s.size() <= short_string_capacity) {
+        memcpy(short_chars(), s.data(), s.size());
+        m_short_size = uint8_t(s.size());
+        return;
+    }
+
+    m_value.storage = create<string_t>(resource, s.data(), s.size());
 }
 
 
@@ -137,17 +389,23 @@ son::son(const son& other) noexcept
             m_value.floating = other.m_value.floating;
             break;
         case type_t::string: {
-            string_t* copy = new string_t(*(string_t*)other.m_value.storage);
+            if (other.m_short_size != long_string) {
+                memcpy(short_chars(), other.short_chars(), short_string_capacity);
+                m_short_size = other.m_short_size;
+                break;
+            }
+
+            string_t* copy = create<string_t>(std::pmr::get_default_resource(), *(string_t*)other.m_value.storage);
             m_value.storage = copy;
             break;
         }
         case type_t::object: {
-            object_t* copy = new object_t(*(object_t*)other.m_value.storage);
+            object_t* copy = create<object_t>(std::pmr::get_default_resource(), *(object_t*)other.m_value.storage);
             m_value.storage = copy;
             break;
         }
         case type_t::array: {
-            array_t* copy = new array_t(*(array_t*)other.m_value.storage);
+            array_t* copy = create<array_t>(std::pmr::get_default_resource(), *(array_t*)other.m_value.storage);
             m_value.storage = copy;
             break;
         }
@@ -175,6 +433,8 @@ son& son::operator=(son&& other) noexcept {
 void son::swap(son& other) noexcept {
     std::swap(m_type, other.m_type);
     std::swap(m_value, other.m_value);
+    std::swap(m_short_tail, other.m_short_tail);
+    std::swap(m_short_size, other.m_short_size);
 }
 
 
@@ -186,12 +446,7 @@ bool son::operator==(const son& other) const {
     case type_t::boolean: return get_boolean() == other.get_boolean();
     case type_t::integer: return get_integer() == other.get_integer();
     case type_t::floating: return get_floating() == other.get_floating();
-    case type_t::string: {
-        string_t* p_storage = (string_t*)m_value.storage;
-        string_t* p_other_storage = (string_t*)other.m_value.storage;
-
-        return (*p_storage) == (*p_other_storage);
-    }
+    case type_t::string: return get_string_view() == other.get_string_view();
     case type_t::object: {
         object_t* p_storage = (object_t*)m_value.storage;
         object_t* p_other_storage = (object_t*)other.m_value.storage;
@@ -213,6 +468,11 @@ bool son::operator==(const son& other) const {
 
 
 son& son::operator[](const char* key) {
+    return operator[](std::string_view(key));
+}
+
+
+son& son::operator[](std::string_view key) {
     assert(is_null() || is_object());
 
     if (is_null()) {
@@ -221,10 +481,27 @@ son& son::operator[](const char* key) {
 
     object_t* p_storage = (object_t*)m_value.storage;
 
-    for (auto& pair : (*p_storage)) {
-        if (pair.first == std::string(key)) {
-            return pair.second;
-        }
+    if (auto* pair = p_storage->find(key)) {
+        return pair->second;
+    }
+
+    push(key, son());
+
+    return (*p_storage)[p_storage->size() - 1].second;
+}
+
+
+son& son::operator[](const key_t& key) {
+    assert(is_null() || is_object());
+
+    if (is_null()) {
+        push(key, son());
+    }
+
+    object_t* p_storage = (object_t*)m_value.storage;
+
+    if (auto* pair = p_storage->find(key)) {
+        return pair->second;
     }
 
     push(key, son());
@@ -242,25 +519,30 @@ son& son::operator[](int32_t idx) {
 
 
 const son& son::operator[](const char* key) const {
-    assert(is_null() || is_object());
+    return operator[](std::string_view(key));
+}
 
-    son* self = const_cast<son*>(this);
 
-    if (is_null()) {
-        self->push(key, son());
-    }
+// Result of const lookups of missing keys.
+static const son& null_value() {
+    static const son value;
+    return value;
+}
 
-    object_t* p_storage = (object_t*)m_value.storage;
 
-    for (auto& pair : (*p_storage)) {
-        if (pair.first == std::string(key)) {
-            return pair.second;
-        }
-    }
+const son& son::operator[](std::string_view key) const {
+    assert(is_null() || is_object());
 
-    self->push(key, son());
+    const son* value = find(key);
+    return value ? *value : null_value();
+}
 
-    return (*p_storage)[p_storage->size() - 1].second;
+
+const son& son::operator[](const key_t& key) const {
+    assert(is_null() || is_object());
+
+    const son* value = find(key);
+    return value ? *value : null_value();
 }
 
 
@@ -272,22 +554,57 @@ const son& son::operator[](int32_t idx) const {
 }
 
 
-son son::get(const char* key, const son& default_value) {
+son* son::find(std::string_view key) {
+    return const_cast<son*>(std::as_const(*this).find(key));
+}
+
+
+son* son::find(const key_t& key) {
+    return const_cast<son*>(std::as_const(*this).find(key));
+}
+
+
+const son* son::find(std::string_view key) const {
+    if (not is_object()) {
+        return nullptr;
+    }
+
+    const object_t* p_storage = (const object_t*)m_value.storage;
+    auto* pair = p_storage->find(key);
+    return pair ? &pair->second : nullptr;
+}
+
+
+const son* son::find(const key_t& key) const {
+    if (not is_object()) {
+        return nullptr;
+    }
+
+    const object_t* p_storage = (const object_t*)m_value.storage;
+    auto* pair = p_storage->find(key);
+    return pair ? &pair->second : nullptr;
+}
+
+
+son son::get(const char* key, const son& default_value) const {
+    return get(std::string_view(key), default_value);
+}
+
+
+son son::get(std::string_view key, const son& default_value) const {
     assert(is_object());
     object_t* p_storage = (object_t*)m_value.storage;
 
-    for (auto& pair : (*p_storage)) {
-        if (pair.first == std::string(key)) {
-            if (pair.second.is_null()) return default_value;
-            return pair.second;
-        }
+    auto* pair = p_storage->find(key);
+    if (not pair or pair->second.is_null()) {
+        return default_value;
     }
 
-    return default_value;
+    return pair->second;
 }
 
 
-son son::get(int32_t idx, const son& default_value) {
+son son::get(int32_t idx, const son& default_value) const {
     assert(is_array());
     array_t* p_storage = (array_t*)m_value.storage;
 
@@ -299,7 +616,7 @@ son son::get(int32_t idx, const son& default_value) {
 }
 
 
-void son::push(const std::string& key, const son& value) {
+void son::push(std::string_view key, son value) {
     assert(is_null() || is_object());
 
     if (is_null()) {
@@ -307,12 +624,28 @@ void son::push(const std::string& key, const son& value) {
         this->swap(obj);
     }
 
+    // Key is allocated from the same resource as the object.
     object_t* p_storage = (object_t*)m_value.storage;
-    p_storage->emplace_back(key, value);
+    p_storage->emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::move(value)));
+    p_storage->index_last();
 }
 
 
-void son::push(const son& value) {
+void son::push(key_t key, son value) {
+    assert(is_null() || is_object());
+
+    if (is_null()) {
+        son obj(type_t::object);
+        this->swap(obj);
+    }
+
+    object_t* p_storage = (object_t*)m_value.storage;
+    p_storage->emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::move(value)));
+    p_storage->index_last();
+}
+
+
+void son::push(son value) {
     assert(is_null() || is_array());
 
     if (is_null()) {
@@ -321,7 +654,16 @@ void son::push(const son& value) {
     }
 
     array_t* p_storage = (array_t*)m_value.storage;
-    p_storage->push_back(value);
+    p_storage->push_back(std::move(value));
+}
+
+
+void son::reserve(size_t capacity) {
+    switch (type()) {
+    case type_t::object: ((object_t*)m_value.storage)->reserve(capacity); return;
+    case type_t::array: ((array_t*)m_value.storage)->reserve(capacity); return;
+    default: return;
+    }
 }
 
 
@@ -416,12 +758,18 @@ void son::clear() {
     case type_t::integer: m_value.integer = 0; return;
     case type_t::floating: m_value.floating = 0.0; return;
     case type_t::string: {
+        if (m_short_size != long_string) {
+            m_short_size = 0;
+            return;
+        }
+
         string_t* p_storage = (string_t*)m_value.storage;
         return p_storage->clear();
     }
     case type_t::object: {
         object_t* p_storage = (object_t*)m_value.storage;
-        return p_storage->clear();
+        p_storage->clear();
+        return p_storage->drop_index();
     }
     case type_t::array: {
         array_t* p_storage = (array_t*)m_value.storage;
@@ -507,6 +855,50 @@ void son::const_iterator::set_to_end() {
 }
 
 
+// Quotes, backslashes and control characters are escaped, so the string is parsed back the same.
+static void print_string(FILE* output, std::string_view s) {
+    const char* run = s.data();
+    const char* end = run + s.size();
+
+    fputc('"', output);
+    for (const char* p = run; p < end; p++) {
+        uint8_t c = uint8_t(*p);
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+
+        fwrite(run, 1, p - run, output);
+        run = p + 1;
+
+        switch (c) {
+        case '"': fputs("\\\"", output); break;
+        case '\\': fputs("\\\\", output); break;
+        case '\b': fputs("\\b", output); break;
+        case '\f': fputs("\\f", output); break;
+        case '\n': fputs("\\n", output); break;
+        case '\r': fputs("\\r", output); break;
+        case '\t': fputs("\\t", output); break;
+        default: fprintf(output, "\\u%04x", c); break;
+        }
+    }
+    fwrite(run, 1, end - run, output);
+    fputc('"', output);
+}
+
+
+// Prints the shortest text that is parsed back to the same float. It always has a '.' or an exponent,
+// so that it is not parsed back as an integer.
+static void print_exact_floating(FILE* output, double value) {
+    char text[32];
+    char* end = std::to_chars(text, text + sizeof(text) - 2, value).ptr;
+
+    if (std::find_if(text, end, [](char c) { return c == '.' or c == 'e' or c == 'n'; }) == end) {
+        *end++ = '.';
+        *end++ = '0';
+    }
+
+    fwrite(text, 1, end - text, output);
+}
+
+
 static const char* spaces = "                                                  ";
 int32_t pretty_print_impl(son& value, const print_options& options, int32_t depth) {
     // @Fix: The reason that value is non-constant type is that I didn't make pairs work with constant iterators.
@@ -515,8 +907,11 @@ int32_t pretty_print_impl(son& value, const print_options& options, int32_t dept
     case son::type_t::null: fprintf(options.output, "null"); break;
     case son::type_t::boolean: fprintf(options.output, "%s", value.get_boolean() ? "true" : "false"); break;
     case son::type_t::integer: fprintf(options.output, "%" PRId64, value.get_integer()); break;
-    case son::type_t::floating: fprintf(options.output, "%lf", value.get_floating()); break;
-    case son::type_t::string: fprintf(options.output, "\"%s\"", value.get_string().c_str()); break;
+    case son::type_t::floating:
+        if (options.exact_floats) print_exact_floating(options.output, value.get_floating());
+        else fprintf(options.output, "%lf", value.get_floating());
+        break;
+    case son::type_t::string: print_string(options.output, value.get_string_view()); break;
     case son::type_t::object: {
         bool in_one_line = (options.multiline == print_options::multiline_t::smart && value.deep_size() <= 6)
             || options.multiline == print_options::multiline_t::disabled;
@@ -0,0 +1,386 @@
+#include <view.hpp>
+#include "lexer.hpp"
+#include "structure.hpp"
+#include "input.hpp"
+#include "escape.hpp"
+#include <deque>
+#include <vector>
+
+
+namespace jslavic {
+
+
+struct son_view::node_t {
+    son::type_t type = son::type_t::null;
+    token value; // Token of booleans, numbers and strings.
+    const std::string* unescaped = nullptr; // Strings with escape sequences, once they are decoded.
+
+    // Objects and arrays. Bounds are found when the parent is scanned.
+    const char* begin = nullptr; // First character after the opening bracket.
+    const char* end = nullptr; // Right after the closing bracket.
+    kind_t closing = TOKEN_EOF;
+    size_t depth = 0; // Objects and arrays it is in, itself included.
+    bool scanned = false;
+
+    struct child_t {
+        std::string_view key;
+        node_t* node = nullptr;
+    };
+
+    std::vector<child_t> children;
+};
+
+
+struct son_view::document_t {
+    std::string buffer;
+    input_text input;
+    span text;
+
+    std::deque<node_t> nodes; // Deque does not move nodes when it grows.
+    node_t* root = nullptr;
+    bool failed = false;
+    size_t max_depth = SIZE_MAX;
+
+    std::deque<std::string> unescaped; // Decoded strings of nodes.
+
+    document_t() : input(buffer) {}
+
+    lexer make_lexer(const char* begin, const char* end) {
+        lexer lex;
+        lex.filename = "<view>";
+        lex.quiet = true;
+        lex.text = span(text.begin, end - text.begin);
+        lex.state.current_char = begin;
+        return lex;
+    }
+
+    node_t* new_node(son::type_t type) {
+        nodes.emplace_back();
+        nodes.back().type = type;
+        return &nodes.back();
+    }
+
+    node_t* new_container(const token& t, const char* end, size_t depth) {
+        bool is_object = (t.kind == TOKEN_BRACE_OPEN);
+
+        node_t* node = new_node(is_object ? son::type_t::object : son::type_t::array);
+        node->begin = t.in_text.begin + 1;
+        node->end = end;
+        node->closing = is_object ? TOKEN_BRACE_CLOSE : TOKEN_BRACKET_CLOSE;
+        node->depth = depth;
+        return node;
+    }
+
+    // Makes a node out of the value that starts with token t, inside of `depth` objects and arrays.
+    // Objects and arrays are skipped without lexing, and nesting in them is checked against max_depth.
+    node_t* new_value(lexer& lex, const token& t, size_t depth) {
+        node_t* node = nullptr;
+
+        switch (t.kind) {
+            case TOKEN_KW_NULL:  return new_node(son::type_t::null);
+            case TOKEN_KW_TRUE:
+            case TOKEN_KW_FALSE: node = new_node(son::type_t::boolean); break;
+            case TOKEN_INTEGER:  node = new_node(son::type_t::integer); break;
+            case TOKEN_FLOATING: node = new_node(son::type_t::floating); break;
+            case TOKEN_STRING:   node = new_node(son::type_t::string); break;
+            case TOKEN_BRACE_OPEN:
+            case TOKEN_BRACKET_OPEN: {
+                if (depth >= max_depth) return nullptr;
+
+                const char* after = skip_container(t.in_text.begin, lex.text.begin + lex.text.size, max_depth - depth);
+                if (not after) return nullptr;
+
+                lex.state.current_char = after;
+                return new_container(t, after, depth + 1);
+            }
+            default:
+                return nullptr;
+        }
+
+        node->value = t;
+        return node;
+    }
+
+    bool fail(node_t& node) {
+        node.children.clear();
+        failed = true;
+        return false;
+    }
+
+    // Finds children of an object or array, once.
+    bool scan(node_t& node) {
+        if (node.scanned) {
+            return true;
+        }
+        node.scanned = true;
+
+        lexer lex = make_lexer(node.begin, node.end);
+        bool is_object = (node.type == son::type_t::object);
+        kind_t separator = is_object ? TOKEN_SEMICOLON : TOKEN_COMMA;
+
+        token t;
+        lex.next_token(t);
+
+        while (t.kind != node.closing) {
+            std::string_view key;
+
+            if (is_object) {
+                if (t.kind != TOKEN_IDENTIFIER) return fail(node);
+                key = std::string_view(t.in_text.begin, t.in_text.size);
+
+                lex.next_token(t);
+                if (t.kind != TOKEN_EQUAL_SIGN) return fail(node);
+                lex.next_token(t);
+            }
+
+            node_t* child = new_value(lex, t, node.depth);
+            if (not child) return fail(node);
+            node.children.push_back({ key, child });
+
+            lex.next_token(t);
+            if (t.kind == separator) {
+                lex.next_token(t);
+            }
+        }
+
+        return true;
+    }
+
+    // Body of a string node, decoded once.
+    std::string_view string_of(node_t& node) {
+        if (not node.value.has_escapes) {
+            return std::string_view(node.value.in_text.begin + 1, node.value.in_text.size - 2);
+        }
+
+        if (not node.unescaped) {
+            unescaped.emplace_back();
+            decode_string(node.value, unescaped.back());
+            node.unescaped = &unescaped.back();
+        }
+
+        return *node.unescaped;
+    }
+
+    son scalar_to_son(node_t& node) {
+        switch (node.type) {
+            case son::type_t::boolean: return son(node.value.kind == TOKEN_KW_TRUE);
+            case son::type_t::integer: return son(node.value.value.integer);
+            case son::type_t::floating: return son(node.value.value.floating);
+            case son::type_t::string: return son(string_of(node), std::pmr::get_default_resource());
+            default: return son();
+        }
+    }
+
+    // Object or array that is being converted by to_son.
+    struct frame_t {
+        node_t* node;
+        std::string_view key; // Key in the parent object.
+        son value;
+        size_t next = 0; // Child that is converted next.
+    };
+
+    // Objects and arrays that are open are kept on a stack of their own, so any depth is fine.
+    son to_son(node_t& top) {
+        if (top.type != son::type_t::object and top.type != son::type_t::array) {
+            return scalar_to_son(top);
+        }
+
+        std::vector<frame_t> stack;
+        stack.push_back({ &top, std::string_view(), son(top.type) });
+
+        while (true) {
+            frame_t& frame = stack.back();
+            scan(*frame.node);
+
+            if (frame.next == frame.node->children.size()) {
+                frame_t done = std::move(frame);
+                stack.pop_back();
+
+                if (stack.empty()) {
+                    return std::move(done.value);
+                }
+
+                add_child(stack.back(), done.key, std::move(done.value));
+                continue;
+            }
+
+            node_t::child_t& child = frame.node->children[frame.next++];
+            if (child.node->type == son::type_t::object or child.node->type == son::type_t::array) {
+                stack.push_back({ child.node, child.key, son(child.node->type) });
+            } else {
+                add_child(frame, child.key, scalar_to_son(*child.node));
+            }
+        }
+    }
+
+    static void add_child(frame_t& frame, std::string_view key, son&& value) {
+        if (frame.node->type == son::type_t::object) {
+            frame.value.push(std::string(key), std::move(value));
+        } else {
+            frame.value.push(std::move(value));
+        }
+    }
+
+    // Top level has the same shape as parse() gives: object without braces, single object or array,
+    // or a list of all top level values. Only a single object or array is skipped here, to tell them apart.
+    void open_root(const parser::settings_t& settings) {
+        if (settings.max_bytes != 0 and text.size > settings.max_bytes) {
+            failed = true;
+            return;
+        }
+        if (settings.max_depth != 0) {
+            max_depth = settings.max_depth;
+        }
+
+        const char* end = text.begin + text.size;
+        lexer lex = make_lexer(text.begin, end);
+
+        token t;
+        lex.next_token(t);
+
+        if (t.kind == TOKEN_EOF or t.kind == TOKEN_UNDEFINED) {
+            failed = true;
+            return;
+        }
+
+        // Object without braces counts as an object for max_depth, like in the parser.
+        if (t.kind == TOKEN_IDENTIFIER) {
+            root = new_node(son::type_t::object);
+            root->begin = text.begin;
+            root->end = end;
+            root->depth = 1;
+            return;
+        }
+
+        if (t.kind == TOKEN_BRACE_OPEN or t.kind == TOKEN_BRACKET_OPEN) {
+            const char* after = skip_container(t.in_text.begin, end, max_depth);
+            if (not after) {
+                failed = true;
+                return;
+            }
+
+            token rest;
+            lex.state.current_char = after;
+            lex.next_token(rest);
+
+            if (rest.kind == TOKEN_EOF) {
+                root = new_container(t, after, 1);
+                return;
+            }
+        }
+
+        root = new_node(son::type_t::array);
+        root->begin = text.begin;
+        root->end = end;
+    }
+};
+
+
+son_view::son_view(std::shared_ptr<document_t> document, node_t* node, std::string_view key)
+    : document(std::move(document))
+    , node(node)
+    , m_key(key)
+{}
+
+
+son_view son_view::open(const std::string& filename, const parser::settings_t& settings) {
+    auto document = std::make_shared<document_t>();
+    if (not document->input.open(filename.c_str(), true, settings.max_bytes)) {
+        return son_view();
+    }
+
+    document->text = document->input.text;
+    document->open_root(settings);
+    return son_view(document, document->root, std::string_view());
+}
+
+
+son_view son_view::from_text(std::string text, const parser::settings_t& settings) {
+    auto document = std::make_shared<document_t>();
+    document->buffer = std::move(text);
+    document->text = span(document->buffer.data(), document->buffer.size());
+
+    document->open_root(settings);
+    return son_view(document, document->root, std::string_view());
+}
+
+
+bool son_view::failed() const {
+    return document and document->failed;
+}
+
+
+son::type_t son_view::type() const {
+    return node ? node->type : son::type_t::null;
+}
+
+
+bool son_view::get_boolean() const {
+    assert(is_boolean());
+    return node->value.kind == TOKEN_KW_TRUE;
+}
+
+
+int64_t son_view::get_integer() const {
+    assert(is_integer());
+    return node->value.value.integer;
+}
+
+
+double son_view::get_floating() const {
+    assert(is_floating());
+    return node->value.value.floating;
+}
+
+
+std::string_view son_view::get_string() const {
+    assert(is_string());
+    return document->string_of(*node);
+}
+
+
+son_view son_view::operator[](const char* key) const {
+    return operator[](std::string_view(key));
+}
+
+
+son_view son_view::operator[](std::string_view key) const {
+    if (not is_object() or not document->scan(*node)) {
+        return son_view();
+    }
+
+    for (auto& child : node->children) {
+        if (child.key == key) {
+            return son_view(document, child.node, child.key);
+        }
+    }
+
+    return son_view();
+}
+
+
+son_view son_view::operator[](size_t idx) const {
+    if ((not is_object() and not is_array()) or not document->scan(*node) or idx >= node->children.size()) {
+        return son_view();
+    }
+
+    auto& child = node->children[idx];
+    return son_view(document, child.node, child.key);
+}
+
+
+size_t son_view::size() const {
+    if ((not is_object() and not is_array()) or not document->scan(*node)) {
+        return 0;
+    }
+
+    return node->children.size();
+}
+
+
+son son_view::to_son() const {
+    return node ? document->to_son(*node) : son();
+}
+
+
+} // jslavic
@@ -0,0 +1,82 @@
+#include "test.hpp"
+#include <new>
+#include <algorithm>
+
+using namespace jslavic;
+
+// Parsing allocates once per long key and for the storage of containers, and a little more for the growth
+// of the root and of the parser's own buffers. Short keys are kept inside of pairs and take nothing.
+
+static size_t allocation_count = 0;
+
+void* operator new(size_t size) {
+    allocation_count += 1;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Memory resources of std::pmr allocate with alignment.
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocation_count += 1;
+    size_t align = std::max(size_t(alignment), sizeof(void*));
+    if (void* p = aligned_alloc(align, (std::max(size, size_t(1)) + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+
+// Allocations that do not depend on what is parsed: vectors that double, the first buffers of the parser.
+static size_t growth(size_t count) {
+    size_t doublings = 0;
+    while ((size_t(1) << doublings) < count) {
+        doublings += 1;
+    }
+    return 2 * doublings + 16;
+}
+
+// Parses the text twice into the same value, the second time reuses what the first one allocated.
+static void check(const char* what, const std::string& text, size_t most) {
+    parser p{std::string()};
+    son value;
+
+    for (int time = 0; time < 2; time++) {
+        size_t before = allocation_count;
+        bool successful = p.parse_into(text, value);
+        size_t allocations = allocation_count - before;
+
+        expect(what, successful and allocations <= most);
+        if (allocations > most) {
+            printf("    %zu allocations, at most %zu\n", allocations, most);
+        }
+    }
+}
+
+int main() {
+    for (size_t keys : { 10, 1000, 100000 }) {
+        std::string short_keys;
+        std::string long_keys;
+        std::string sections;
+        for (size_t i = 0; i < keys; i++) {
+            std::string n = std::to_string(i);
+            short_keys += "key_" + n + " = " + n + "\n";
+            long_keys += "a_rather_long_configuration_key_" + n + " = " + n + "\n";
+            sections += "a_rather_long_section_name_" + n + " = { another_long_key_inside = 1; list_with_a_long_key = [ 1 ] }\n";
+        }
+
+        check("short keys", short_keys, growth(keys));
+        check("long keys", long_keys, keys + growth(keys));
+
+        // Three long keys and two containers per section, the object grows once to hold its second pair.
+        // Keys of nested containers must not take a new buffer for the key that follows them.
+        check("long keys in sections", sections, keys * (3 + 2 + 2 + 1) + growth(keys));
+    }
+
+    return finish("allocations");
+}
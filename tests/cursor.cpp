@@ -0,0 +1,80 @@
+#include "test.hpp"
+
+using namespace jslavic;
+
+// Events of the cursor are the events of the parser, and skip_value() stops at the end of what it skipped.
+
+static std::string cursor_events(std::string_view text, bool& successful) {
+    event_log events;
+    cursor c(text);
+    size_t count = 0;
+
+    while (c.next()) {
+        count += 1;
+        if (not c.key().empty()) events.on_key(c.key());
+
+        switch (c.kind()) {
+            case cursor::kind_t::null: events.on_null(); break;
+            case cursor::kind_t::boolean: events.on_boolean(c.get_boolean()); break;
+            case cursor::kind_t::integer: events.on_integer(c.get_integer()); break;
+            case cursor::kind_t::floating: events.on_floating(c.get_floating()); break;
+            case cursor::kind_t::string: events.on_string(c.get_string()); break;
+            case cursor::kind_t::object_begin: events.on_object_begin(); break;
+            case cursor::kind_t::object_end: events.on_object_end(); break;
+            case cursor::kind_t::array_begin: events.on_array_begin(); break;
+            case cursor::kind_t::array_end: events.on_array_end(); break;
+            case cursor::kind_t::none: events.add("none"); break;
+        }
+    }
+
+    successful = not c.failed() and count > 0;
+    return events.log;
+}
+
+static void check_same_events(std::string_view text) {
+    event_log events;
+    parser p{std::string()};
+    bool parsed = p.parse(text, events);
+
+    bool successful = false;
+    std::string log = cursor_events(text, successful);
+    expect("cursor events", log == events.log and successful == parsed);
+}
+
+int main() {
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+        check_same_events(random_document(seed, 1 + seed % 20));
+    }
+
+    check_same_events("{ a = 1; b = 2.5; }");
+    check_same_events("[ 1, 2, 3 ]");
+    check_same_events("\"one\"\n2\n3.0\ntrue\n[ 1 2 3 ]\n");
+    check_same_events("{ a = 1 } { b = 2 }");
+    check_same_events("a = [ { b = \"q\\\"x\" } -.5 +2 ] // c\nz = 1");
+
+    {
+        cursor c("a = { b = [ 1 2 { c = 3 } ] d = 4 } e = 5 f = [ 6 ]");
+        bool successful = c.next() and c.kind() == cursor::kind_t::object_begin and c.depth() == 1;
+        successful = successful and c.next() and c.key() == "a" and c.kind() == cursor::kind_t::object_begin;
+        successful = successful and c.skip_value() and c.kind() == cursor::kind_t::object_end and c.depth() == 1;
+        successful = successful and c.next() and c.key() == "e" and c.get_integer() == 5;
+        successful = successful and c.next() and c.key() == "f" and c.kind() == cursor::kind_t::array_begin;
+        successful = successful and c.skip_value() and c.kind() == cursor::kind_t::array_end;
+        successful = successful and c.next() and c.kind() == cursor::kind_t::object_end and c.depth() == 0;
+        expect("skip value", successful and not c.next() and not c.failed());
+    }
+
+    {
+        cursor c("a = \"line\\nbreak\" b = 2");
+        bool successful = c.next() and c.next() and c.get_string() == "line\nbreak";
+        expect("decoded string", successful and c.next() and c.get_floating() == 2.0);
+    }
+
+    for (const char* text : { "a = = 1", "a = 1 @", "a = \"unterminated\n", "a = { b = 1" }) {
+        cursor c(text);
+        while (c.next()) {}
+        expect("cursor fails", c.failed());
+    }
+
+    return finish("cursor");
+}
@@ -0,0 +1,48 @@
+#include "test.hpp"
+
+using namespace jslavic;
+
+// Trees in the arena of a document are equal to trees on the heap, and copies outlive the document.
+
+int main() {
+    parser p{std::string()};
+    document reused;
+
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+        std::string text = random_document(seed, 1 + seed % 20);
+        son heap;
+        bool successful = p.parse_into(text, heap);
+
+        expect("arena tree", p.parse_into(text, reused) == successful and reused.value() == heap);
+
+        son copy;
+        {
+            document d;
+            p.parse_into(text, d);
+            copy = d.value();
+        }
+        expect("copy outlives", copy == heap);
+    }
+
+    expect("invalid", not p.parse_into("a = = 1", reused) and reused.value().is_null());
+
+    {
+        document d;
+        p.parse_into("a = { b = \"long string value that is not short\" } c = [1 2 3]", d);
+        d.value().push("heap", son("another long string that goes to the heap"));
+        d.value()["a"].push("x", son({ 1, 2, 3 }));
+        son kept = d.value()["a"];
+
+        document moved = std::move(d);
+        document assigned;
+        assigned = std::move(moved);
+        expect("moved document", assigned.value()["heap"].get_string_view() == "another long string that goes to the heap"
+            and assigned.value()["a"]["x"][2].get_integer() == 3);
+
+        assigned.clear();
+        expect("cleared", assigned.value().is_null());
+        expect("kept", kept["b"].get_string_view() == "long string value that is not short" and kept["x"].size() == 3);
+    }
+
+    return finish("document");
+}
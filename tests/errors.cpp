@@ -0,0 +1,68 @@
+#include "test.hpp"
+
+using namespace jslavic;
+
+// Documents that are not valid give a message that says what is wrong and where.
+
+int main() {
+    struct case_t {
+        const char* text;
+        const char* message;
+    };
+
+    case_t cases[] = {
+        { "a = \"unclosed\nb = 1", ":1:5: error: unclosed double quote\n" },
+        { "a 1", ":1:3: error: expected ’=’, but found integer ’1’\n" },
+        { "a = 1\ntrue = 2", ":2:1: error: expected identifier, but found true ’true’\n" },
+        { "a = { b = 1", ":1:12: error: expected ’}’, but found EOF ’’\n" },
+        { "a = [ 1 2", ":1:10: error: expected ’]’, but found EOF ’’\n" },
+        { "a = [ 1 2 }", ":1:11: error: expected value, but found } ’}’\n" },
+        { "a = ", ":1:5: error: expected value, but found EOF ’’\n" },
+        { "a = 1 @", ":1:7: error: unknown lexeme ’@’\n" },
+        { "a = \"\\q\"", ":1:6: error: unknown escape sequence ’\\q’\n" },
+    };
+
+    std::vector<std::string_view> texts;
+    for (const case_t& c : cases) {
+        texts.push_back(c.text);
+    }
+
+    std::vector<parse_result> results = parse_many_texts(texts, 1);
+    for (size_t i = 0; i < results.size(); i++) {
+        const std::string& errors = results[i].errors;
+        std::string_view message = cases[i].message;
+
+        // One message, after the name of the input.
+        bool found = errors.size() >= message.size() and errors.compare(errors.size() - message.size(), message.size(), message) == 0;
+        expect(cases[i].text, not results[i].successful and found and errors.find('\n') == errors.size() - 1);
+        if (not found) {
+            printf("    got: %s", errors.c_str());
+        }
+    }
+
+    // Bytes count from the start of the file also when its parts are parsed on several threads,
+    // or only the values at some paths are.
+    std::string text;
+    for (int i = 0; i < 2000; i++) {
+        text += "key_" + std::to_string(i) + " = \"text\";\n";
+    }
+    size_t byte = text.find("key_1900") + 13; // The 'e' of its "text".
+    text[byte] = char(0xFF);
+
+    char message[100];
+    snprintf(message, sizeof(message), ":1901:14: error: string is not valid UTF-8 at byte %zu\n", byte);
+
+    parser::settings_t settings;
+    settings.validate_utf8 = true;
+    settings.threads = 4;
+    settings.parallel_threshold = 0;
+    std::vector<parse_result> parallel = parse_many_texts({ text }, 1, settings);
+    expect("byte in part", not parallel[0].successful and parallel[0].errors.find(message) != std::string::npos);
+
+    parser p(std::string(), settings);
+    son found;
+    std::string output = printed_by([&] { found = p.parse_paths(text, { "key_1900", "key_1999" }); });
+    expect("byte in path", found.is_null() and output.find(message) != std::string::npos);
+
+    return finish("errors");
+}
@@ -0,0 +1,113 @@
+#include "test.hpp"
+
+using namespace jslavic;
+
+// Text fed in pieces of any size gives the events and values that the whole text gives.
+
+static bool feed_in_pieces(incremental_parser& p, std::string_view text, random_t& random, size_t longest) {
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t step = std::min<size_t>(1 + random.next(longest), text.size() - position);
+        if (not p.feed(text.data() + position, step)) {
+            return false;
+        }
+        position += step;
+    }
+    return p.finish();
+}
+
+static void check_events(std::string_view text, uint32_t seed) {
+    event_log whole;
+    parser p{std::string()};
+    bool parsed = p.parse(text, whole);
+
+    for (size_t longest : { 1, 7, 64 }) {
+        random_t random{ seed };
+        event_log pieces;
+        incremental_parser ip(pieces);
+        bool fed = feed_in_pieces(ip, text, random, longest);
+        expect("incremental events", pieces.log == whole.log and fed == parsed);
+    }
+}
+
+// Pieces of one text in memory, fed in place, then the rest copied.
+static void check_in_place(std::string_view text, uint32_t seed) {
+    event_log whole;
+    parser p{std::string()};
+    bool parsed = p.parse(text, whole);
+
+    random_t random{ seed };
+    event_log pieces;
+    incremental_parser ip(pieces);
+    size_t position = 0;
+    size_t copied_from = text.size() - random.next(uint32_t(text.size() / 4 + 1));
+    bool fed = true;
+
+    while (fed and position < text.size()) {
+        size_t step = std::min<size_t>(1 + random.next(32), text.size() - position);
+        fed = (position < copied_from) ? ip.feed_in_place(text.data() + position, step) : ip.feed(text.data() + position, step);
+        position += step;
+    }
+    fed = fed and ip.finish();
+    expect("in place events", pieces.log == whole.log and fed == parsed);
+}
+
+static void check_values(std::string_view text, uint32_t seed) {
+    parser p{std::string()};
+    son whole = p.parse(text);
+
+    random_t random{ seed };
+    incremental_parser ip;
+    bool fed = feed_in_pieces(ip, text, random, 16);
+
+    son value;
+    std::vector<son> values;
+    while (ip.next_value(value)) {
+        values.push_back(value);
+    }
+
+    // parse() puts several top level values into a list.
+    bool same = values.size() == 1 and values[0] == whole;
+    if (values.size() > 1) {
+        same = whole.is_array() and whole.size() == values.size();
+        for (size_t i = 0; same and i < values.size(); i++) {
+            same = whole[int32_t(i)] == values[i];
+        }
+    }
+    expect("incremental values", fed and same);
+}
+
+int main() {
+    for (uint32_t seed = 1; seed <= 100; seed++) {
+        std::string text = random_document(seed, 1 + seed % 15);
+        check_events(text, seed);
+        check_in_place(text, seed);
+        check_values(text, seed);
+    }
+
+    // Pieces that end inside of strings, escapes, comments and numbers.
+    const char* texts[] = {
+        "a = \"a string that is cut \\\" after an escape\" // a comment / with slashes\nb = -12345.678e-2",
+        "{ a = 1 } { b = \"x\" } [ 1 2 ] \"top\" 42",
+        "a = \"//not a comment\" / b = 1",
+        "a = 1 @",
+        "a = { b = 1",
+        "a = \"unterminated",
+    };
+    for (const char* text : texts) {
+        for (uint32_t seed = 1; seed <= 20; seed++) {
+            check_events(text, seed);
+            check_in_place(text, seed);
+        }
+    }
+
+    {
+        incremental_parser ip;
+        son value;
+        bool successful = ip.feed("{ a = 1 } { b") and ip.next_value(value) and value["a"].get_integer() == 1;
+        successful = successful and not ip.next_value(value) and ip.feed(" = 2 }") and ip.next_value(value);
+        expect("value when it closes", successful and value["b"].get_integer() == 2 and ip.finish() and not ip.failed());
+    }
+
+    return finish("incremental");
+}
@@ -0,0 +1,87 @@
+#include "test.hpp"
+#include <map>
+#include <thread>
+
+using namespace jslavic;
+
+// Lookups in objects give the first pair with the key, below and above the size that builds an index,
+// while the object grows, after it is copied or cleared, and on several threads at once.
+
+int main() {
+    for (int count : { 0, 1, 15, 16, 17, 33, 100, 5000 }) {
+        son object(son::type_t::object);
+        std::map<std::string, int64_t> expected;
+
+        for (int i = 0; i < count; i++) {
+            std::string key = (i % 3 ? "key_" : "a_much_longer_key_name_") + std::to_string(i);
+            object.push(key, son(int64_t(i)));
+            expected[key] = i;
+            if (i == count / 2) expect("lookup while growing", object[std::string_view(key)].get_integer() == i);
+        }
+        if (count > 1) {
+            object.push("key_1", son(int64_t(-1)));
+        }
+
+        const son& constant = object;
+        for (auto& [key, value] : expected) {
+            expect("lookup", object[key.c_str()].get_integer() == value and object[intern(key)].get_integer() == value);
+            expect("const lookup", constant[std::string_view(key)].get_integer() == value and constant.find(key)->get_integer() == value);
+            expect("get", object.get(std::string_view(key), son(int64_t(-9))).get_integer() == value);
+        }
+        expect("missing", object.get("nope", son(int64_t(-9))).get_integer() == -9 and not constant.contains("nope"));
+
+        size_t size = object.size();
+        object["fresh"] = son(int64_t(77));
+        expect("insert", object.size() == size + 1 and object["fresh"].get_integer() == 77);
+
+        son copy = object;
+        expect("copy", copy == object and copy["fresh"].get_integer() == 77);
+
+        object.clear();
+        expect("cleared", object.size() == 0 and not object.contains("fresh"));
+        for (int i = 0; i < 200; i++) {
+            object.push("k" + std::to_string(i), son(int64_t(i)));
+        }
+        expect("refilled", object["k150"].get_integer() == 150 and object["k199"].get_integer() == 199);
+    }
+
+    std::string text = "small = { a = 1; b = \"x\" }\n";
+    for (int i = 0; i < 2000; i++) {
+        text += "route_" + std::to_string(i) + " = " + std::to_string(i) + "\n";
+    }
+
+    for (int mode = 0; mode < 3; mode++) {
+        parser::settings_t settings;
+        settings.intern_keys = (mode == 2);
+        parser p(std::string(), settings);
+
+        document d;
+        son owned;
+        if (mode == 1) p.parse_into(text, d);
+        else owned = p.parse(text);
+        const son& config = (mode == 1) ? d.value() : owned;
+
+        // Concurrent reads of a const object, the first of them builds the index.
+        std::vector<std::thread> threads;
+        std::vector<size_t> failures(4);
+        for (size_t t = 0; t < failures.size(); t++) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < 2000; i++) {
+                    std::string key = "route_" + std::to_string(i);
+                    const son* value = config.find(key);
+                    if (not value or value->get_integer() != i) failures[t]++;
+                    if (config.find(intern(key)) != value) failures[t]++;
+                    if (config.contains("missing_" + key) or not config["small"]["nope"].is_null()) failures[t]++;
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (size_t f : failures) {
+            expect("concurrent lookups", f == 0);
+        }
+    }
+
+    return finish("index");
+}
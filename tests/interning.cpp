@@ -0,0 +1,69 @@
+#include "test.hpp"
+#include <thread>
+
+using namespace jslavic;
+
+// Interned and plain keys give the same trees and lookups, also when keys are interned on several threads.
+
+int main() {
+    parser::settings_t interned;
+    interned.intern_keys = true;
+
+    for (uint32_t seed = 1; seed <= 100; seed++) {
+        std::string text = random_document(seed, 1 + seed % 20);
+        son plain = parser(std::string()).parse(text);
+        parser p(std::string(), interned);
+        son with_ids = p.parse(text);
+        expect("same tree", plain == with_ids);
+
+        son reused;
+        p.parse_into(text, reused);
+        p.parse_into(text, reused);
+        expect("reparsed", reused == plain);
+
+        document d;
+        p.parse_into(text, d);
+        expect("document", d.value() == plain);
+    }
+
+    std::string text = "a = 1; very_long_key_name_over_16 = { x = \"s\"; id = [1, 2, { name = 3 }] }";
+    son plain = parser(std::string()).parse(text);
+    son with_ids = parser(std::string(), interned).parse(text);
+
+    son::key_t key = intern("very_long_key_name_over_16");
+    expect("interned id", key.id() != 0 and with_ids.pairs().begin().key().id() != 0);
+    expect("plain id", plain.pairs().begin().key().id() == 0);
+    expect("lookup by id", with_ids[key]["x"].get_string_view() == "s" and plain[key]["x"].get_string_view() == "s");
+    expect("lookup by text", with_ids["very_long_key_name_over_16"]["id"][2]["name"].get_integer() == 3);
+
+    son mixed;
+    mixed.push("id", son(int64_t(1)));
+    mixed.push(intern("name"), son(int64_t(2)));
+    expect("mixed keys", mixed["name"].get_integer() == 2 and mixed[intern("id")].get_integer() == 1 and mixed.size() == 2);
+
+    son::key_t short_key("short");
+    son::key_t long_key(std::string_view("a_key_longer_than_sixteen_bytes"));
+    son::key_t copied = long_key;
+    expect("key copy", copied == long_key);
+    copied = short_key;
+    expect("key assign", copied == "short");
+
+    std::vector<std::thread> threads;
+    std::vector<son> results(8);
+    for (size_t i = 0; i < results.size(); i++) {
+        threads.emplace_back([&, i] {
+            std::string own = text + " thread_" + std::to_string(i) + "_key_that_is_long = " + std::to_string(i);
+            results[i] = parser(std::string(), interned).parse(own);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < results.size(); i++) {
+        std::string own_key = "thread_" + std::to_string(i) + "_key_that_is_long";
+        expect("threads", results[i]["very_long_key_name_over_16"] == plain["very_long_key_name_over_16"]
+            and results[i][intern(own_key)].get_integer() == int64_t(i));
+    }
+
+    return finish("interning");
+}
@@ -0,0 +1,43 @@
+#include "test.hpp"
+
+using namespace jslavic;
+
+// parse_many() gives what parser gives for each input, in the order of the inputs, on any number of threads.
+
+int main() {
+    std::vector<std::string> texts;
+    for (uint32_t seed = 1; seed <= 60; seed++) {
+        texts.push_back(random_document(seed, 1 + seed % 30));
+    }
+    texts.push_back("a = = 1");
+    texts.push_back("");
+
+    std::vector<std::string> filenames;
+    for (const std::string& text : texts) {
+        filenames.push_back(temporary_file(text));
+    }
+    filenames.push_back("/nonexistent/file.son");
+
+    std::vector<std::string_view> views(texts.begin(), texts.end());
+    for (size_t threads : { 1, 3, 0 }) {
+        std::vector<parse_result> from_texts = parse_many_texts(views, threads);
+        std::vector<parse_result> from_files = parse_many(filenames, threads);
+        expect("result count", from_texts.size() == texts.size() and from_files.size() == filenames.size());
+
+        for (size_t i = 0; i < texts.size() and i < from_texts.size() and i < from_files.size(); i++) {
+            parser p{std::string()};
+            son value;
+            bool successful = p.parse_into(texts[i], value);
+
+            expect("text result", from_texts[i].successful == successful and from_texts[i].value == value);
+            expect("file result", from_files[i].successful == successful and from_files[i].value == value);
+            expect("errors", successful == from_texts[i].errors.empty() and successful == from_files[i].errors.empty());
+        }
+        expect("missing file", not from_files.back().successful and not from_files.back().errors.empty());
+    }
+
+    for (const std::string& filename : filenames) {
+        unlink(filename.c_str());
+    }
+    return finish("many");
+}
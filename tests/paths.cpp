@@ -0,0 +1,86 @@
+#include "test.hpp"
+
+using namespace jslavic;
+
+// parse_paths() gives the values that parse() has at the same paths.
+
+static void collect_paths(const son& value, const std::string& path, random_t& random, std::vector<std::string>& paths) {
+    if (not path.empty() and random.next(2) == 0) {
+        paths.push_back(path);
+    }
+
+    if (value.is_object()) {
+        for (auto [key, child] : value.pairs()) {
+            if (random.next(2) == 0) collect_paths(child, path.empty() ? std::string(key) : path + "." + std::string(key), random, paths);
+        }
+    } else if (value.is_array()) {
+        for (size_t i = 0; i < value.size(); i++) {
+            if (random.next(2) == 0) collect_paths(value[int32_t(i)], path + "[" + std::to_string(i) + "]", random, paths);
+        }
+    }
+}
+
+// Value at the path the way find() sees it: the first pair with the key.
+static const son* find_path(const son& root, std::string_view path) {
+    const son* current = &root;
+    size_t position = 0;
+    while (current and position < path.size()) {
+        if (path[position] == '[') {
+            size_t close = path.find(']', position);
+            size_t idx = std::stoul(std::string(path.substr(position + 1, close - position - 1)));
+            current = (current->is_array() and idx < current->size()) ? &(*current)[int32_t(idx)] : nullptr;
+            position = close + 1;
+        } else {
+            if (path[position] == '.') position += 1;
+            size_t end = path.find_first_of(".[", position);
+            if (end == std::string_view::npos) end = path.size();
+            current = current->find(path.substr(position, end - position));
+            position = end;
+        }
+    }
+    return current;
+}
+
+int main() {
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+        std::string text = random_document(seed, 1 + seed % 20);
+        parser p{std::string()};
+        son whole = p.parse(text);
+
+        random_t random{ seed };
+        std::vector<std::string> paths;
+        collect_paths(whole, "", random, paths);
+        paths.push_back("no_such_key.x");
+        paths.push_back("a[999999]");
+
+        son found = p.parse_paths(text, paths);
+        expect("paths parsed", found.is_object());
+        for (const std::string& path : paths) {
+            const son* expected = find_path(whole, path);
+            const son* got = found.find(path);
+            expect("path value", expected ? got and *got == *expected : got == nullptr);
+        }
+    }
+
+    {
+        parser p{std::string()};
+        son found = p.parse_paths("server = { port = 80; hosts = [ \"a\", \"b\" ] } server = { port = 81 }", { "server.port", "server.hosts[1]", "server.hosts[2]" });
+        expect("first key wins", found["server.port"].get_integer() == 80 and found["server.hosts[1]"].get_string_view() == "b");
+        expect("missing index", not found.contains("server.hosts[2]"));
+    }
+
+    {
+        parser p{std::string()};
+        expect("invalid document", p.parse_paths("a = 1 b = = 2", { "a" }).is_null());
+    }
+
+    // Keywords are not keys: the document is not valid and the error is reported.
+    for (const char* text : { "a = 1\ntrue = 2", "server = { null = 1; port = 80 }" }) {
+        parser p{std::string()};
+        son found;
+        std::string output = printed_by([&] { found = p.parse_paths(text, { "a", "server.port" }); });
+        expect("keyword key", found.is_null() and output.find("error: expected identifier, but found") != std::string::npos);
+    }
+
+    return finish("paths");
+}
@@ -0,0 +1,102 @@
+#include "test.hpp"
+#include <string.h>
+#include <math.h>
+
+using namespace jslavic;
+
+// What record_writer writes, record_reader reads back the same, with and without memory mapping.
+
+static void check_round_trip(const std::vector<son>& records) {
+    std::string filename = temporary_file("");
+    {
+        record_writer writer(filename);
+        for (const son& record : records) {
+            expect("write", writer.write(record));
+        }
+        expect("flush", writer.flush() and writer.good());
+    }
+
+    for (bool use_mmap : { true, false }) {
+        record_reader reader(filename, use_mmap);
+        son record;
+        size_t count = 0;
+        while (reader.next(record)) {
+            expect("same record", count < records.size() and record == records[count]);
+            count += 1;
+        }
+        expect("all records", count == records.size() and not reader.failed());
+    }
+
+    unlink(filename.c_str());
+}
+
+int main() {
+    std::vector<son> records;
+    parser p{std::string()};
+    for (uint32_t seed = 1; seed <= 2000; seed++) {
+        records.push_back(p.parse(random_document(seed, 1 + seed % 10)));
+    }
+    records.push_back(son(int64_t(7)));
+    records.push_back(son("a string record"));
+    records.push_back(son({ 1, 2, 3 }));
+    check_round_trip(records);
+
+    // Floating numbers come back with the same bits.
+    double samples[] = { 1e-10, 0.1234567891234, 0.1, 2.0, -0.0, 1e22, 5e-324, 1.7976931348623157e308, 123456789012345678.0, 3.14159265358979 };
+    std::vector<son> floats;
+    for (double sample : samples) {
+        son record(son::type_t::object);
+        record.push("x", son(sample));
+        floats.push_back(record);
+    }
+    check_round_trip(floats);
+    {
+        std::string filename = temporary_file("");
+        {
+            record_writer writer(filename);
+            for (const son& record : floats) writer.write(record);
+        }
+        record_reader reader(filename);
+        son record;
+        size_t i = 0;
+        while (reader.next(record) and i < floats.size()) {
+            double value = record["x"].is_floating() ? record["x"].get_floating() : 1.0;
+            expect("same bits", memcmp(&value, &samples[i], sizeof(double)) == 0);
+            i += 1;
+        }
+        expect("all floats", i == floats.size());
+        unlink(filename.c_str());
+    }
+
+    // Records that would not be read back are not written.
+    son rejected[] = {
+        son({ 1.0, son(INFINITY) }),
+        son(NAN),
+        son(son::type_t::object),
+        son(son::type_t::object),
+        son(son::type_t::object),
+        son(son::type_t::object),
+    };
+    rejected[2].push("a b", son(int64_t(1)));
+    rejected[3].push("true", son(int64_t(1)));
+    rejected[4].push("", son(int64_t(1)));
+    rejected[5].push("ok", son({ son(int64_t(1)), son(son::type_t::object) }));
+    rejected[5]["ok"][1].push("9lives", son(int64_t(1)));
+    for (const son& record : rejected) {
+        std::string filename = temporary_file("");
+        record_writer writer(filename);
+        expect("rejected", not writer.write(record) and not writer.good());
+        unlink(filename.c_str());
+    }
+
+    {
+        std::string filename = temporary_file("{ a = 1 }\n{ a = 2 }\n{ a = \n");
+        record_reader reader(filename);
+        son record;
+        bool successful = reader.next(record) and record["a"].get_integer() == 1 and reader.next(record);
+        expect("unfinished record", successful and not reader.next(record) and reader.failed());
+        unlink(filename.c_str());
+    }
+
+    return finish("records");
+}
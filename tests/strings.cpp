@@ -0,0 +1,68 @@
+#include "test.hpp"
+#include <memory_resource>
+
+using namespace jslavic;
+
+// Strings of 0..40 bytes, short ones kept inside of the value and longer ones not, through copies,
+// moves, assignments, clear(), an arena, objects and parsing.
+
+static void check_length(size_t length) {
+    std::string s;
+    for (size_t i = 0; i < length; i++) {
+        s += char('a' + i % 26);
+    }
+
+    son a(s);
+    expect("view", a.get_string_view() == s and a.get_string() == s);
+
+    son b = a;
+    expect("copy", b == a and b.get_string_view() == s);
+
+    son c = std::move(b);
+    expect("move", c.get_string_view() == s);
+
+    son array(son::type_t::array);
+    array.push(a);
+    array.push(son(int64_t(1)));
+    array.push(a);
+    son copy = array;
+    expect("deep copy", copy == array and copy[2].get_string_view() == s);
+
+    son d(int64_t(5));
+    d = a;
+    expect("assign", d.get_string_view() == s);
+
+    a = son(int64_t(3));
+    expect("assign over", a.is_integer() and a.get_integer() == 3);
+
+    son e(s);
+    e.clear();
+    expect("clear", e.is_string() and e.get_string_view().empty());
+
+    std::string other = s;
+    if (length > 0) other[length - 1] = 'Z';
+    expect("compare", length == 0 or not (son(other) == son(s)));
+
+    std::pmr::monotonic_buffer_resource arena;
+    son f(std::string_view(s), &arena);
+    expect("arena", f.get_string_view() == s);
+
+    son object(son::type_t::object);
+    object.push("k", f);
+    object.push("a_rather_long_key", son(s));
+    expect("object", object["k"].get_string_view() == s and object["a_rather_long_key"] == f);
+}
+
+int main() {
+    for (size_t length = 0; length <= 40; length++) {
+        check_length(length);
+    }
+
+    parser p{std::string()};
+    son parsed = p.parse("a = \"short\"; b = \"fourteen_chars\"; c = \"fifteen__chars!\"; d = [\"\\u00e9x\", \"\"]");
+    expect("parsed", parsed["a"].get_string_view() == "short" and parsed["b"].get_string_view() == "fourteen_chars"
+        and parsed["c"].get_string_view() == "fifteen__chars!" and parsed["d"][0].get_string_view() == "\xC3\xA9x"
+        and parsed["d"][1].get_string_view().empty());
+
+    return finish("strings");
+}
@@ -0,0 +1,183 @@
+#ifndef SON_TEST_HPP
+#define SON_TEST_HPP
+
+#include <son.hpp>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <string_view>
+
+// What every test uses: checks that count failures, a generator of random documents,
+// a handler that writes events down as text, temporary files and printed output.
+
+inline size_t failed_checks = 0;
+
+inline void expect(const char* what, bool ok) {
+    if (not ok) {
+        printf("check failed: %s\n", what);
+        failed_checks += 1;
+    }
+}
+
+// Returns the exit code of the test.
+inline int finish(const char* name) {
+    if (failed_checks == 0) {
+        printf("%s: passed\n", name);
+        return 0;
+    }
+
+    printf("%s: %zu checks failed\n", name, failed_checks);
+    return 1;
+}
+
+struct random_t {
+    uint32_t seed;
+
+    uint32_t next(uint32_t bound) {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) % bound;
+    }
+};
+
+inline void append_value(std::string& text, random_t& random, size_t depth);
+
+// Some keys repeat, some are longer than 16 bytes.
+inline void append_key(std::string& text, random_t& random) {
+    static const char* keys[] = { "a", "id", "name", "value", "_hidden", "x1", "a_key_longer_than_sixteen_bytes", "nested_configuration_section" };
+    text += keys[random.next(8)];
+}
+
+// Pairs are separated by ';' and elements by ',', both are optional.
+inline void append_separator(std::string& text, random_t& random, bool in_object) {
+    switch (random.next(5)) {
+        case 0: text += in_object ? "; " : ", "; break;
+        case 1: text += in_object ? ";\n" : ",\n"; break;
+        case 2: text += "\n"; break;
+        case 3: text += " // comment, with { [ \" inside\n"; break;
+        default: text += " "; break;
+    }
+}
+
+inline void append_pairs(std::string& text, random_t& random, size_t depth, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        append_key(text, random);
+        text += " = ";
+        append_value(text, random, depth);
+        append_separator(text, random, true);
+    }
+}
+
+inline void append_value(std::string& text, random_t& random, size_t depth) {
+    static const char* strings[] = {
+        "\"\"", "\"short\"", "\"fourteen_chars\"", "\"a string that does not fit into the value\"",
+        "\"quote \\\" and backslash \\\\\"", "\"line\\nbreak\\ttab\"", "\"\\u00e9t\\u00e9\"", "\"caf\xC3\xA9\"",
+    };
+    static const char* numbers[] = {
+        "0", "-1", "42", "9223372036854775807", "-9223372036854775807", "2.5", "-0.125", "6.02e23", "1e-3", "0.1",
+    };
+
+    uint32_t kind = random.next(depth < 5 ? 7 : 5);
+    switch (kind) {
+        case 0: text += random.next(2) ? "true" : "false"; break;
+        case 1: text += "null"; break;
+        case 2: text += numbers[random.next(10)]; break;
+        case 3:
+        case 4: text += strings[random.next(8)]; break;
+        case 5: {
+            text += "{ ";
+            append_pairs(text, random, depth + 1, random.next(6));
+            text += "}";
+            break;
+        }
+        case 6: {
+            text += "[ ";
+            size_t count = random.next(6);
+            for (size_t i = 0; i < count; i++) {
+                append_value(text, random, depth + 1);
+                append_separator(text, random, false);
+            }
+            text += "]";
+            break;
+        }
+    }
+}
+
+// Valid document with an object without braces at the top level.
+inline std::string random_document(uint32_t seed, size_t pairs) {
+    random_t random{ seed };
+    std::string text;
+    append_pairs(text, random, 0, pairs);
+    return text;
+}
+
+// Writes events down one per line, to compare what different readers report.
+struct event_log : jslavic::sax_handler {
+    std::string log;
+
+    void add(const char* event, std::string_view text = std::string_view()) {
+        log += event;
+        log.append(text.data(), text.size());
+        log += '\n';
+    }
+
+    bool on_null() override { add("null"); return true; }
+    bool on_boolean(bool v) override { add(v ? "true" : "false"); return true; }
+    bool on_integer(int64_t v) override { add("integer ", std::to_string(v)); return true; }
+    bool on_floating(double v) override {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.17g", v);
+        add("floating ", buffer);
+        return true;
+    }
+    bool on_string(std::string_view v) override { add("string ", v); return true; }
+    bool on_key(std::string_view v) override { add("key ", v); return true; }
+    bool on_object_begin() override { add("{"); return true; }
+    bool on_object_end() override { add("}"); return true; }
+    bool on_array_begin() override { add("["); return true; }
+    bool on_array_end() override { add("]"); return true; }
+};
+
+// Writes text into a new temporary file and returns its name. The test removes it.
+inline std::string temporary_file(std::string_view text) {
+    char name[] = "/tmp/son_test_XXXXXX";
+    int descriptor = mkstemp(name);
+    if (descriptor < 0) {
+        perror("mkstemp");
+        exit(1);
+    }
+
+    if (write(descriptor, text.data(), text.size()) != ssize_t(text.size())) {
+        perror("write");
+        exit(1);
+    }
+    close(descriptor);
+    return name;
+}
+
+// Runs the function and returns what it printed, errors of the parser included.
+template <typename Function>
+std::string printed_by(Function function) {
+    fflush(stdout);
+    FILE* file = tmpfile();
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(file), STDOUT_FILENO);
+
+    function();
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    std::string output;
+    char chunk[4096];
+    rewind(file);
+    for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0; ) {
+        output.append(chunk, n);
+    }
+    fclose(file);
+    return output;
+}
+
+#endif // SON_TEST_HPP
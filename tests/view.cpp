@@ -0,0 +1,101 @@
+#include "test.hpp"
+
+using namespace jslavic;
+
+// Walking a son_view gives the values that parse() gives, scanned or not, and limits are kept.
+
+static bool same_as(const son_view& view, const son& value) {
+    if (not view.exists() or view.type() != value.type()) {
+        return false;
+    }
+
+    switch (value.type()) {
+        case son::type_t::null: return true;
+        case son::type_t::boolean: return view.get_boolean() == value.get_boolean();
+        case son::type_t::integer: return view.get_integer() == value.get_integer();
+        case son::type_t::floating: return view.get_floating() == value.get_floating();
+        case son::type_t::string: return view.get_string() == value.get_string_view();
+        case son::type_t::object: {
+            if (view.size() != value.size()) return false;
+            size_t i = 0;
+            for (auto [key, child] : value.pairs()) {
+                son_view child_view = view[i++];
+                if (child_view.key() != key or not same_as(child_view, child)) return false;
+            }
+            // Lookup by key finds the first pair, as son does.
+            for (auto [key, child] : value.pairs()) {
+                if (not (view[std::string_view(key)].to_son() == value[std::string_view(key)])) return false;
+            }
+            return true;
+        }
+        case son::type_t::array: {
+            if (view.size() != value.size()) return false;
+            for (size_t i = 0; i < value.size(); i++) {
+                if (not same_as(view[i], value[int32_t(i)])) return false;
+            }
+            return not view[value.size()].exists();
+        }
+    }
+    return false;
+}
+
+static std::string nested(size_t depth) {
+    std::string text = "a = ";
+    for (size_t i = 0; i < depth; i++) text += "[";
+    for (size_t i = 0; i < depth; i++) text += "]";
+    return text;
+}
+
+int main() {
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+        std::string text = random_document(seed, 1 + seed % 20);
+        son value = parser{std::string()}.parse(text);
+
+        expect("to_son", son_view::from_text(text).to_son() == value);
+        son_view view = son_view::from_text(text);
+        expect("walk", same_as(view, value) and not view.failed());
+    }
+
+    {
+        son_view view = son_view::from_text("a = \"x\\ty\" b = { c = [ 1 2 \"\\u00e9\" ] } d = { e = 1 } broken = { f = @ }");
+        expect("decoded", view["a"].get_string() == "x\ty" and view["b"]["c"][2].get_string() == "\xC3\xA9");
+        expect("same buffer", view["a"].get_string().data() == view["a"].get_string().data());
+        expect("missing", not view["nope"].exists() and not view["b"]["c"][3].exists() and not view["a"]["x"].exists());
+        expect("untouched", view["d"]["e"].get_integer() == 1 and not view.failed());
+        expect("broken", not view["broken"]["f"].exists() and view.failed());
+    }
+
+    {
+        son_view view = son_view::from_text("[ 1 2 ] [ 3 ]");
+        expect("top level values", view.is_array() and view.size() == 2 and view[1][0].get_integer() == 3);
+    }
+
+    parser::settings_t settings;
+    settings.max_depth = 8;
+    expect("max depth", son_view::from_text(nested(7), settings)["a"].exists());
+    son_view deep = son_view::from_text(nested(8), settings);
+    expect("over max depth", deep.exists() and not deep.failed() and not deep["a"].exists() and deep.failed());
+    son_view braced = son_view::from_text("{" + nested(8) + "}", settings);
+    expect("braced over max depth", not braced.exists() and braced.failed());
+
+    settings = parser::settings_t();
+    settings.max_bytes = 10;
+    son_view large = son_view::from_text("a = \"more than ten bytes\"", settings);
+    expect("max bytes", not large.exists() and large.failed());
+
+    settings = parser::settings_t();
+    settings.max_depth = 0;
+    son deep_value = son_view::from_text(nested(2000), settings).to_son();
+    expect("deep to_son", deep_value["a"].is_array());
+
+    {
+        std::string text = random_document(7, 30);
+        std::string filename = temporary_file(text);
+        son value = parser{std::string()}.parse(text);
+        expect("open", son_view::open(filename).to_son() == value);
+        unlink(filename.c_str());
+        expect("no file", not son_view::open(filename).exists());
+    }
+
+    return finish("view");
+}